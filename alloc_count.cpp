@@ -0,0 +1,110 @@
+#include "alloc_count.h"
+
+#include "SDL.h"
+
+#include <atomic>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+static std::atomic<Uint64> gAllocationCount(0);
+
+Uint64 heap_allocation_count()
+{
+    return gAllocationCount.load(std::memory_order_relaxed);
+}
+
+// SDL's own allocations, counted and passed on to whatever SDL was using before
+static SDL_malloc_func gSDLMalloc;
+static SDL_calloc_func gSDLCalloc;
+static SDL_realloc_func gSDLRealloc;
+static SDL_free_func gSDLFree;
+
+static void* SDLCALL counted_malloc(size_t size)
+{
+    gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    return gSDLMalloc(size);
+}
+
+static void* SDLCALL counted_calloc(size_t count, size_t size)
+{
+    gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    return gSDLCalloc(count, size);
+}
+
+static void* SDLCALL counted_realloc(void* memory, size_t size)
+{
+    gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    return gSDLRealloc(memory, size);
+}
+
+void heap_track_sdl_allocations()
+{
+    if(gSDLMalloc) return;
+    
+    SDL_GetMemoryFunctions(&gSDLMalloc, &gSDLCalloc, &gSDLRealloc, &gSDLFree);
+    if(SDL_SetMemoryFunctions(counted_malloc, counted_calloc, counted_realloc, gSDLFree) < 0)
+    {
+        printf("Unable to track SDL allocations! SDL_Error: %s\n", SDL_GetError());
+    }
+}
+
+// Every new in the program comes through here
+void* operator new(size_t size)
+{
+    gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    
+    void* memory = malloc(size ? size : 1);
+    if(memory == NULL) throw std::bad_alloc();
+    
+    return memory;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+    free(memory);
+}
+
+// C++14 calls these instead when it knows the size, they'd otherwise go straight to the runtime's
+#if defined(__cpp_sized_deallocation) || defined(_MSC_VER)
+void operator delete(void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+    free(memory);
+}
+#endif
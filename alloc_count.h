@@ -0,0 +1,18 @@
+#ifndef ALLOC_COUNT_H
+#define ALLOC_COUNT_H
+
+#include "SDL_stdinc.h"
+
+// Counts heap allocations by replacing the global operator new and delete. Only the game and the
+// simulation bench link alloc_count.cpp, everything else (breakout_sim included) keeps the
+// runtime's allocator.
+
+// Heap allocations made through new, new[] (arena chunks included) and, once
+// heap_track_sdl_allocations has been called, SDL_malloc, SDL_calloc and SDL_realloc, from any
+// thread. Whatever SDL's drivers and the C runtime malloc for themselves directly isn't seen.
+Uint64 heap_allocation_count();
+
+// Has to happen before SDL_Init so nothing SDL allocates ends up freed by the wrong functions
+void heap_track_sdl_allocations();
+
+#endif
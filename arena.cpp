@@ -0,0 +1,120 @@
+#include "arena.h"
+
+#include "SDL.h"
+
+#include <new>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static ArenaChunk* arena_chunk_create(ArenaChunk* prev, size_t size)
+{
+    // Through new so the game's allocation count (alloc_count.cpp) sees chunks too
+    ArenaChunk* chunk = (ArenaChunk*)operator new(sizeof(ArenaChunk) + size, std::nothrow);
+    if(chunk == NULL)
+    {
+        printf("Unable to allocate a %u byte arena chunk!\n", (unsigned)size);
+        abort();
+    }
+    
+    chunk->prev = prev;
+    chunk->size = size;
+    chunk->used = 0;
+    
+    return chunk;
+}
+
+static void arena_free_chunks(Arena& arena)
+{
+    while(arena.current)
+    {
+        ArenaChunk* prev = arena.current->prev;
+        operator delete(arena.current);
+        arena.current = prev;
+    }
+}
+
+void arena_create(Arena& arena, size_t size)
+{
+    arena = Arena();
+    arena.current = arena_chunk_create(NULL, size);
+}
+
+void arena_destroy(Arena& arena)
+{
+    arena_free_chunks(arena);
+    arena = Arena();
+}
+
+void arena_reset(Arena& arena)
+{
+    if(arena.current && arena.current->prev)
+    {
+        // Spilled over since the last reset, fold it all into one chunk that would have fit it
+        size_t size = 0;
+        for(ArenaChunk* chunk = arena.current; chunk; chunk = chunk->prev)
+        {
+            size += chunk->size;
+        }
+        
+        arena_free_chunks(arena);
+        arena.current = arena_chunk_create(NULL, size);
+    }
+    
+    if(arena.current) arena.current->used = 0;
+    arena.used = 0;
+}
+
+void* arena_push(Arena& arena, size_t size, size_t alignment)
+{
+    ArenaChunk* chunk = arena.current;
+    
+    // Aligned relative to the chunk's bytes, which are only as aligned as new makes them, so
+    // worst case pad by a whole alignment
+    size_t offset = 0;
+    if(chunk)
+    {
+        uintptr_t base = (uintptr_t)(chunk + 1);
+        offset = ((base + chunk->used + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+    }
+    
+    if(chunk == NULL || offset + size > chunk->size)
+    {
+        size_t chunkSize = chunk ? chunk->size * 2 : 4096;
+        if(chunkSize < size + alignment) chunkSize = size + alignment;
+        
+        chunk = arena_chunk_create(chunk, chunkSize);
+        arena.current = chunk;
+        
+        uintptr_t base = (uintptr_t)(chunk + 1);
+        offset = ((base + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+    }
+    
+    void* result = (Uint8*)(chunk + 1) + offset;
+    memset(result, 0, size);
+    
+    arena.used += offset + size - chunk->used;
+    if(arena.used > arena.peak) arena.peak = arena.used;
+    chunk->used = offset + size;
+    
+    return result;
+}
+
+char* arena_printf(Arena& arena, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int length = SDL_vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    
+    if(length < 0) length = 0;
+    
+    char* text = (char*)arena_push(arena, length + 1, 1);
+    
+    va_start(args, format);
+    SDL_vsnprintf(text, length + 1, format, args);
+    va_end(args);
+    
+    return text;
+}
@@ -0,0 +1,60 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "SDL_stdinc.h"
+
+#include <stddef.h>
+
+// Cache line, so SoA arrays pushed one after another don't share lines
+const size_t ARENA_ALIGNMENT = 64;
+
+// A chunk's header sits in front of its bytes
+struct ArenaChunk
+{
+    ArenaChunk* prev;
+    size_t size;
+    size_t used;
+};
+
+// Linear allocator, pushes bump a pointer and everything is freed at once by arena_reset. When a
+// chunk fills up another is chained on, and the next reset swaps them all for one chunk big enough
+// for the high water mark, so an arena reset every frame stops allocating after the first few.
+struct Arena
+{
+    ArenaChunk* current;
+    size_t used; // across every chunk since the last reset
+    size_t peak;
+};
+
+void arena_create(Arena& arena, size_t size);
+void arena_destroy(Arena& arena);
+
+void arena_reset(Arena& arena);
+
+// Zeroed, never NULL
+void* arena_push(Arena& arena, size_t size, size_t alignment);
+
+// printf into the arena, the string lives until the next reset
+char* arena_printf(Arena& arena, const char* format, ...);
+
+template<typename T>
+T* arena_push_array(Arena& arena, int count)
+{
+    return (T*)arena_push(arena, count * sizeof(T), ARENA_ALIGNMENT);
+}
+
+// For storage that may or may not have an arena behind it: from the arena if there is one, else
+// new[]. Delete is a no-op for arena storage, it goes with the next reset.
+template<typename T>
+T* arena_new_array(Arena* arena, int count)
+{
+    return arena ? arena_push_array<T>(*arena, count) : new T[count]();
+}
+
+template<typename T>
+void arena_delete_array(Arena* arena, T* array)
+{
+    if(arena == NULL) delete[] array;
+}
+
+#endif
@@ -0,0 +1,195 @@
+#include "batch_env.h"
+
+#include <string.h>
+
+static Uint32 batch_env_random(BatchEnv& env, int index)
+{
+    // xorshift32, one state per env so envs don't depend on which thread ran them
+    Uint32 x = env.randomState[index];
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    env.randomState[index] = x;
+    
+    return x;
+}
+
+static int batch_env_count_alive(BatchEnv& env, int index)
+{
+    Uint64* active = &env.active[index * env.numBlockWords];
+    
+    int count = 0;
+    for(int word = 0; word < env.numBlockWords; ++word)
+    {
+        count += bit_count(active[word]);
+    }
+    
+    return count;
+}
+
+static void batch_env_observe(BatchEnv& env, int index)
+{
+    World& world = env.worlds[index];
+    BallPool& balls = world.balls;
+    float* obs = &env.observations[index * env.obsSize];
+    
+    obs[0] = (float)world.paddle.posX / world.width;
+    obs[1] = (float)balls.posX[0] / world.width;
+    obs[2] = (float)balls.posY[0] / world.height;
+    obs[3] = (float)balls.velX[0] / BALL_MAX_VEL;
+    obs[4] = (float)balls.velY[0] / BALL_MAX_VEL;
+    
+    Uint64* active = world.blocks.active;
+    for(int i = 0; i < world.blocks.numBlocks; ++i)
+    {
+        obs[BATCH_ENV_OBS_HEADER + i] = (float)((active[i >> 6] >> (i & 63)) & 1);
+    }
+}
+
+static void batch_env_reset_env(BatchEnv& env, int index)
+{
+    World& world = env.worlds[index];
+    World& level = *env.level;
+    
+    world.tick = 0;
+    world.paddle = level.paddle;
+    
+    memcpy(world.blocks.active, level.blocks.active, env.numBlockWords * sizeof(Uint64));
+    memcpy(world.blocks.hitPoints, level.blocks.hitPoints, level.blocks.capacity);
+    env.numAlive[index] = batch_env_count_alive(env, index);
+    
+    BallPool& balls = world.balls;
+    int w = level.balls.w[0];
+    int h = level.balls.h[0];
+    Uint32 random = batch_env_random(env, index);
+    
+    balls.posX[0] = (int)(random % (Uint32)(world.width - w + 1));
+    balls.posY[0] = level.balls.posY[0];
+    balls.prevPosX[0] = balls.posX[0];
+    balls.prevPosY[0] = balls.posY[0];
+    balls.velX[0] = (random >> 31) ? BALL_VEL : -BALL_VEL;
+    balls.velY[0] = -BALL_VEL;
+    balls.w[0] = w;
+    balls.h[0] = h;
+}
+
+void batch_env_create(BatchEnv& env, World& level, int numEnvs, Uint32 seed)
+{
+    env.numEnvs = numEnvs;
+    env.obsSize = BATCH_ENV_OBS_HEADER + level.blocks.numBlocks;
+    env.numBlockWords = level.blocks.capacity / 64;
+    env.level = &level;
+    
+    int capacity = level.blocks.capacity;
+    size_t perEnv = sizeof(World) + 8 * sizeof(int) + env.numBlockWords * sizeof(Uint64) + capacity +
+                    sizeof(int) + sizeof(Uint32) + env.obsSize * sizeof(float) + sizeof(float) + 1;
+    arena_create(env.arena, numEnvs * perEnv + 16 * ARENA_ALIGNMENT);
+    
+    env.worlds = arena_push_array<World>(env.arena, numEnvs);
+    env.ballPosX = arena_push_array<int>(env.arena, numEnvs);
+    env.ballPosY = arena_push_array<int>(env.arena, numEnvs);
+    env.ballPrevPosX = arena_push_array<int>(env.arena, numEnvs);
+    env.ballPrevPosY = arena_push_array<int>(env.arena, numEnvs);
+    env.ballVelX = arena_push_array<int>(env.arena, numEnvs);
+    env.ballVelY = arena_push_array<int>(env.arena, numEnvs);
+    env.ballW = arena_push_array<int>(env.arena, numEnvs);
+    env.ballH = arena_push_array<int>(env.arena, numEnvs);
+    env.active = arena_push_array<Uint64>(env.arena, numEnvs * env.numBlockWords);
+    env.hitPoints = arena_push_array<Uint8>(env.arena, numEnvs * capacity);
+    env.numAlive = arena_push_array<int>(env.arena, numEnvs);
+    env.randomState = arena_push_array<Uint32>(env.arena, numEnvs);
+    env.observations = arena_push_array<float>(env.arena, numEnvs * env.obsSize);
+    env.rewards = arena_push_array<float>(env.arena, numEnvs);
+    env.dones = arena_push_array<Uint8>(env.arena, numEnvs);
+    
+    for(int i = 0; i < numEnvs; ++i)
+    {
+        World& world = env.worlds[i];
+        world = level;
+        
+        // Rects, colors and the grid stay the level's, borrowed so nothing ever writes or frees them
+        world.blocks.borrowed = true;
+        world.blocks.arena = NULL;
+        world.blocks.active = &env.active[i * env.numBlockWords];
+        world.blocks.hitPoints = &env.hitPoints[i * capacity];
+        
+        BallPool& balls = world.balls;
+        balls.numBalls = 1;
+        balls.capacity = 1;
+        balls.posX = &env.ballPosX[i];
+        balls.posY = &env.ballPosY[i];
+        balls.prevPosX = &env.ballPrevPosX[i];
+        balls.prevPosY = &env.ballPrevPosY[i];
+        balls.velX = &env.ballVelX[i];
+        balls.velY = &env.ballVelY[i];
+        balls.w = &env.ballW[i];
+        balls.h = &env.ballH[i];
+        
+        // xorshift is stuck at 0
+        Uint32 state = (seed + (Uint32)i) * 2654435761u;
+        env.randomState[i] = state ? state : 1;
+    }
+    
+    batch_env_reset(env);
+}
+
+void batch_env_destroy(BatchEnv& env)
+{
+    arena_destroy(env.arena);
+    env = BatchEnv();
+}
+
+void batch_env_reset(BatchEnv& env)
+{
+    for(int i = 0; i < env.numEnvs; ++i)
+    {
+        batch_env_reset_env(env, i);
+        batch_env_observe(env, i);
+        env.rewards[i] = 0.0f;
+        env.dones[i] = 0;
+    }
+}
+
+struct BatchEnvStep
+{
+    BatchEnv* env;
+    const int* actions;
+};
+
+static void batch_env_step_job(void* data, int begin, int end)
+{
+    BatchEnvStep& step = *(BatchEnvStep*)data;
+    BatchEnv& env = *step.env;
+    
+    for(int i = begin; i < end; ++i)
+    {
+        World& world = env.worlds[i];
+        
+        // world_step without its profiler scopes, those aren't safe off the main thread
+        WorldInput input = {clamp(step.actions[i], -1, 1) * MOVE_VEL};
+        world_step_paddle(world, input);
+        world_step_balls(world, 0, 1);
+        ++world.tick;
+        
+        int numAlive = batch_env_count_alive(env, i);
+        float reward = (float)(env.numAlive[i] - numAlive);
+        env.numAlive[i] = numAlive;
+        
+        // The bottom is open, once the ball is all the way through it it's gone
+        bool missed = world.balls.posY[0] > world.height;
+        if(missed) reward -= 1.0f;
+        
+        bool done = missed || numAlive == 0 || world.tick >= BATCH_ENV_MAX_TICKS;
+        if(done) batch_env_reset_env(env, i);
+        
+        env.rewards[i] = reward;
+        env.dones[i] = done;
+        batch_env_observe(env, i);
+    }
+}
+
+void batch_env_step(BatchEnv& env, const int* actions, JobSystem& jobs)
+{
+    BatchEnvStep step = {&env, actions};
+    job_parallel_for(jobs, env.numEnvs, BATCH_ENV_PER_JOB, batch_env_step_job, &step);
+}
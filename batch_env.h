@@ -0,0 +1,69 @@
+#ifndef BATCH_ENV_H
+#define BATCH_ENV_H
+
+// Many independent games stepped together, for training agents: no window, renderer or SDL_Init.
+// Every env plays the same level, the block rects, colors and grid are borrowed read-only from a
+// template world and each env only owns its paddle, its ball, its alive bits and hit points. Those
+// are packed into arrays across all envs so a step over a batch of envs streams through memory.
+
+#include "simulation.h"
+#include "jobs.h"
+#include "arena.h"
+
+// Observation of one env: paddle x, ball x, ball y (0..1 of the play area), ball velocity x and y
+// (-1..1 of BALL_MAX_VEL), then one per block, 1 while it's alive
+const int BATCH_ENV_OBS_HEADER = 5;
+
+const int BATCH_ENV_PER_JOB = 256;
+
+// Episodes are cut off after this many ticks (done, no penalty) so a ball stuck bouncing between
+// the paddle and a wall can't hold an env forever
+const Uint64 BATCH_ENV_MAX_TICKS = 60 * WORLD_TICKS_PER_SECOND;
+
+struct BatchEnv
+{
+    int numEnvs;
+    int obsSize;
+    int numBlockWords;
+    
+    World* level;  // the template, must outlive the env
+    World* worlds; // one per env, never passed to world_destroy
+    
+    // The single ball of each env, backing each world's BallPool
+    int* ballPosX;
+    int* ballPosY;
+    int* ballPrevPosX;
+    int* ballPrevPosY;
+    int* ballVelX;
+    int* ballVelY;
+    int* ballW;
+    int* ballH;
+    
+    Uint64* active;   // numBlockWords per env
+    Uint8* hitPoints; // level->blocks.capacity per env
+    int* numAlive;
+    
+    Uint32* randomState;
+    
+    // Written by reset and step, numEnvs * obsSize observations and one reward and done per env
+    float* observations;
+    float* rewards;
+    Uint8* dones;
+    
+    Arena arena; // everything above
+};
+
+// level is a world_create or world_create_from_level world with one ball, only read from here on
+void batch_env_create(BatchEnv& env, World& level, int numEnvs, Uint32 seed);
+void batch_env_destroy(BatchEnv& env);
+
+// Starts a new episode in every env, the ball starts at a random x heading up to the left or right
+void batch_env_reset(BatchEnv& env);
+
+// One tick of every env. actions holds one per env, -1 left, 0 stay, 1 right.
+// The reward is one per block destroyed and -1 for letting the ball past the paddle, which ends the
+// episode, as does clearing every block or running out of ticks. Finished envs are reset straight
+// away, their observation is already the first of the next episode.
+void batch_env_step(BatchEnv& env, const int* actions, JobSystem& jobs);
+
+#endif
@@ -0,0 +1,167 @@
+// Renders synthetic levels of increasing block counts with the software renderer into an offscreen
+// surface and reports frames per second and draw calls per frame. The cached path is world_render,
+// exactly what the game draws, with the blocks copied out of the block layer. Batched is the same
+// with the layer turned off, and immediate fills every rect with its own call, for comparison.
+// No window is created.
+
+#include "SDL.h"
+
+#include "simulation.h"
+#include "render.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+const int BENCH_WIDTH = 640;
+const int BENCH_HEIGHT = 480;
+
+// Blocks are tiled across the top two thirds of the screen, in three bands of color
+static void bench_level_create(World& world, int numBlocks, int numBalls)
+{
+    world_create_empty(world, BENCH_WIDTH, BENCH_HEIGHT);
+    ball_pool_destroy(world.balls);
+    
+    SDL_Color colors[3] = {{0xFF, 0x00, 0x00, 0xFF}, {0x00, 0xFF, 0x00, 0xFF}, {0x00, 0x00, 0xFF, 0xFF}};
+    for(int i = 0; i < 3; ++i)
+    {
+        world.colors[i] = colors[i];
+    }
+    world.numColors = 3;
+    
+    // Smallest square cell that fits numBlocks into the area
+    int areaHeight = BENCH_HEIGHT * 2 / 3;
+    int cell = 1;
+    while((BENCH_WIDTH / (cell + 1)) * (areaHeight / (cell + 1)) >= numBlocks) ++cell;
+    
+    int blocksPerLine = BENCH_WIDTH / cell;
+    int blockSize = cell > 1 ? cell - 1 : 1; // leave a gap so the blocks don't merge
+    
+    for(int i = 0; i < numBlocks; ++i)
+    {
+        SDL_Rect collider = {(i % blocksPerLine) * cell, (i / blocksPerLine) * cell, blockSize, blockSize};
+        block_store_add(world.blocks, collider, i * 3 / numBlocks, 1);
+    }
+    
+    for(int i = 0; i < numBalls; ++i)
+    {
+        ball_pool_spawn(world.balls, (i * 37) % (BENCH_WIDTH - 25), areaHeight + (i * 11) % (BENCH_HEIGHT - areaHeight - 25), 0, 0, 25, 25);
+    }
+}
+
+// What drawing looked like before batching, one SDL call per rect
+static void bench_render_immediate(SDL_Renderer* renderer, World& world)
+{
+    SDL_Color clearColor = {0xFF, 0xFF, 0xFF, 0xFF};
+    SDL_Color paddleColor = {0x00, 0x00, 0x00, 0xFF};
+    SDL_Color ballColor = {0x00, 0xFF, 0x00, 0xFF};
+    
+    SDL_SetRenderDrawColor(renderer, clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+    SDL_RenderClear(renderer);
+    
+    for(int i = 0; i < world.blocks.numBlocks; ++i)
+    {
+        if(!block_is_active(world.blocks, i)) continue;
+        
+        SDL_Rect collider = block_collider(world.blocks, i);
+        render_fill_rect(renderer, world.colors[world.blocks.color[i]], &collider);
+    }
+    
+    render_fill_rect(renderer, paddleColor, &world.paddle.collider);
+    
+    for(int i = 0; i < world.balls.numBalls; ++i)
+    {
+        SDL_Rect collider = ball_pool_interpolate(world.balls, i, 1.0f);
+        render_fill_rect(renderer, ballColor, &collider);
+    }
+}
+
+enum BenchRenderPath
+{
+    BENCH_IMMEDIATE,
+    BENCH_BATCHED,
+    BENCH_CACHED,
+};
+
+static void bench_level(SDL_Renderer* renderer, int numBlocks, int numBalls, int numFrames, BenchRenderPath path)
+{
+    static const char* pathNames[] = {"immediate", "batched", "cached"};
+    
+    World world;
+    bench_level_create(world, numBlocks, numBalls);
+    
+    WorldRenderer worldRenderer = {};
+    worldRenderer.blockLayerUnsupported = path != BENCH_CACHED;
+    int drawCalls = 0;
+    
+    Uint64 start = SDL_GetPerformanceCounter();
+    
+    for(int frame = 0; frame < numFrames; ++frame)
+    {
+        render_stats_reset();
+        
+        if(path == BENCH_IMMEDIATE)
+        {
+            bench_render_immediate(renderer, world);
+        }
+        else
+        {
+            world_render(renderer, worldRenderer, world, world.paddle.collider, 1.0f);
+        }
+        
+        SDL_RenderPresent(renderer);
+        drawCalls = gRenderStats.drawCalls;
+    }
+    
+    double seconds = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+    
+    printf("%-9s %6d blocks %4d balls: %8.1f frames/s, %6d draw calls/frame\n", pathNames[path], numBlocks, numBalls,
+           numFrames / seconds, drawCalls);
+    
+    world_renderer_destroy(worldRenderer);
+    world_destroy(world);
+}
+
+#undef main
+int main(int argc, char *argv[])
+{
+    int numFrames = 200;
+    if(argc > 1)
+    {
+        numFrames = atoi(argv[1]);
+    }
+    
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+    
+    if(SDL_Init(SDL_INIT_VIDEO) < 0)
+    {
+        printf("SDL could not init! SDL_Error: %s\n", SDL_GetError());
+        return 1;
+    }
+    
+    SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, BENCH_WIDTH, BENCH_HEIGHT, 32, SDL_PIXELFORMAT_RGBA32);
+    SDL_Renderer* renderer = target ? SDL_CreateSoftwareRenderer(target) : NULL;
+    if(renderer == NULL)
+    {
+        printf("Software renderer could not be created! SDL Error: %s\n", SDL_GetError());
+        return 1;
+    }
+    
+    const int blockCounts[] = {36, 1000, 10000, 50000};
+    const int ballCounts[] = {1, 100};
+    
+    for(int balls = 0; balls < 2; ++balls)
+    {
+        for(int blocks = 0; blocks < 4; ++blocks)
+        {
+            bench_level(renderer, blockCounts[blocks], ballCounts[balls], numFrames, BENCH_CACHED);
+            bench_level(renderer, blockCounts[blocks], ballCounts[balls], numFrames, BENCH_BATCHED);
+            bench_level(renderer, blockCounts[blocks], ballCounts[balls], numFrames, BENCH_IMMEDIATE);
+        }
+    }
+    
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(target);
+    SDL_Quit();
+    
+    return 0;
+}
@@ -0,0 +1,318 @@
+// Steps the headless simulation as fast as possible and reports ticks per second, first for the
+// normal single ball game, then with a pool of 1k, 10k and 100k balls, then 100k balls spread over
+// 1 to N threads to see how the parallel update scales. Also times world snapshots and a batch of
+// 4096 separate games (the training environment) over 1 to N threads.
+// No window, renderer or font is created.
+
+#include "SDL.h"
+
+#include "simulation.h"
+#include "snapshot.h"
+#include "batch_env.h"
+#include "alloc_count.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+const int BENCH_WIDTH = 640;
+const int BENCH_HEIGHT = 480;
+
+// Steps of random batch env actions made before timing, 1 MB for 4096 envs
+const int BENCH_BATCH_ACTION_STEPS = 64;
+
+static Uint32 gRandomState = 12345;
+
+static int bench_random(int min, int max)
+{
+    gRandomState = gRandomState * 1664525 + 1013904223;
+    return min + (int)((gRandomState >> 8) % (Uint32)(max - min + 1));
+}
+
+static void bench_spawn_ball(World& world)
+{
+    int velX = bench_random(-BALL_MAX_VEL, BALL_MAX_VEL);
+    int velY = -bench_random(1, BALL_MAX_VEL);
+    ball_pool_spawn(world.balls, bench_random(0, world.width - 25), bench_random(world.height / 4, world.height / 2), velX, velY, 25, 25);
+}
+
+// Nothing stops a ball leaving the bottom yet, send lost balls back up so collisions keep happening
+static void bench_respawn_lost_balls(World& world)
+{
+    BallPool& balls = world.balls;
+    for(int i = 0; i < balls.numBalls; ++i)
+    {
+        if(balls.posY[i] > world.height)
+        {
+            balls.posY[i] = world.height / 2;
+            balls.velY[i] = -bench_random(1, BALL_MAX_VEL);
+        }
+    }
+}
+
+static double bench_seconds_since(Uint64 start)
+{
+    return (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+static void bench_single_ball(Uint64 numTicks)
+{
+    World world;
+    world_create(world, BENCH_WIDTH, BENCH_HEIGHT);
+    
+    WorldInput input = {};
+    
+    Uint64 start = SDL_GetPerformanceCounter();
+    
+    for(Uint64 i = 0; i < numTicks; ++i)
+    {
+        // Sweep the paddle back and forth so the paddle path is exercised too
+        input.paddleVelX = ((i / 64) & 1) ? MOVE_VEL : -MOVE_VEL;
+        world_step(world, input);
+        
+        // Start over so block collisions keep happening
+        if(world.balls.posY[0] > world.height)
+        {
+            world_destroy(world);
+            world_create(world, BENCH_WIDTH, BENCH_HEIGHT);
+        }
+    }
+    
+    double seconds = bench_seconds_since(start);
+    
+    printf("single ball: %llu ticks in %.3f s, %.0f ticks/s\n", (unsigned long long)numTicks, seconds, numTicks / seconds);
+    
+    world_destroy(world);
+}
+
+static void bench_ball_pool(int numBalls, Uint64 numTicks)
+{
+    World world;
+    world_create(world, BENCH_WIDTH, BENCH_HEIGHT);
+    
+    for(int i = 1; i < numBalls; ++i)
+    {
+        bench_spawn_ball(world);
+    }
+    
+    WorldInput input = {};
+    
+    Uint64 allocations = heap_allocation_count();
+    Uint64 start = SDL_GetPerformanceCounter();
+    
+    for(Uint64 i = 0; i < numTicks; ++i)
+    {
+        input.paddleVelX = ((i / 64) & 1) ? MOVE_VEL : -MOVE_VEL;
+        world_step(world, input);
+        bench_respawn_lost_balls(world);
+    }
+    
+    double seconds = bench_seconds_since(start);
+    allocations = heap_allocation_count() - allocations;
+    
+    printf("%6d balls: %llu ticks in %.3f s, %.1f ticks/s, %.0f ball ticks/s, %llu heap allocations\n", numBalls, (unsigned long long)numTicks,
+           seconds, numTicks / seconds, (double)numBalls * numTicks / seconds, (unsigned long long)allocations);
+    
+    world_destroy(world);
+}
+
+// Returns false if a save and load didn't give back the same world
+static bool bench_snapshot(int numBalls, int numRepeats)
+{
+    World world;
+    world_create(world, BENCH_WIDTH, BENCH_HEIGHT);
+    
+    for(int i = 1; i < numBalls; ++i)
+    {
+        bench_spawn_ball(world);
+    }
+    
+    // Play a second first so there are dead blocks and moved balls to get back
+    WorldInput input = {MOVE_VEL};
+    for(int i = 0; i < WORLD_TICKS_PER_SECOND; ++i)
+    {
+        world_step(world, input);
+        bench_respawn_lost_balls(world);
+    }
+    
+    std::vector<Uint8> snapshot(world_snapshot_size(world));
+    
+    // Nothing else round trips a snapshot, so check it's lossless while we're here
+    Uint64 hash = world_hash(world);
+    
+    Uint64 start = SDL_GetPerformanceCounter();
+    for(int i = 0; i < numRepeats; ++i)
+    {
+        world_snapshot_save(world, snapshot.data(), snapshot.size());
+    }
+    double saveSeconds = bench_seconds_since(start);
+    
+    start = SDL_GetPerformanceCounter();
+    for(int i = 0; i < numRepeats; ++i)
+    {
+        if(!world_snapshot_load(world, snapshot.data(), snapshot.size()))
+        {
+            printf("%6d ball snapshot: load failed!\n", numBalls);
+            world_destroy(world);
+            return false;
+        }
+    }
+    double loadSeconds = bench_seconds_since(start);
+    
+    Uint64 loadedHash = world_hash(world);
+    if(loadedHash != hash)
+    {
+        printf("%6d ball snapshot: hash %016llx after a load, %016llx before the save!\n", numBalls,
+               (unsigned long long)loadedHash, (unsigned long long)hash);
+        world_destroy(world);
+        return false;
+    }
+    
+    printf("%6d ball snapshot: %zu bytes, save %.2f us, load %.2f us\n", numBalls, snapshot.size(),
+           saveSeconds * 1000000.0 / numRepeats, loadSeconds * 1000000.0 / numRepeats);
+    
+    world_destroy(world);
+    
+    return true;
+}
+
+static void bench_thread_scaling(int numBalls, Uint64 numTicks, int numThreads)
+{
+    JobSystem jobs;
+    job_system_create(jobs, numThreads);
+    
+    // Same seed every run so each thread count sees the same balls
+    gRandomState = 12345;
+    
+    World world;
+    world_create(world, BENCH_WIDTH, BENCH_HEIGHT);
+    
+    for(int i = 1; i < numBalls; ++i)
+    {
+        bench_spawn_ball(world);
+    }
+    
+    WorldInput input = {};
+    
+    Uint64 allocations = heap_allocation_count();
+    Uint64 start = SDL_GetPerformanceCounter();
+    
+    for(Uint64 i = 0; i < numTicks; ++i)
+    {
+        input.paddleVelX = ((i / 64) & 1) ? MOVE_VEL : -MOVE_VEL;
+        world_step_parallel(world, input, jobs);
+        bench_respawn_lost_balls(world);
+    }
+    
+    double seconds = bench_seconds_since(start);
+    allocations = heap_allocation_count() - allocations;
+    
+    printf("%2d threads: %llu ticks in %.3f s, %.1f ticks/s, %.0f ball ticks/s, %llu heap allocations\n", numThreads, (unsigned long long)numTicks,
+           seconds, numTicks / seconds, (double)numBalls * numTicks / seconds, (unsigned long long)allocations);
+    
+    world_destroy(world);
+    job_system_destroy(jobs);
+}
+
+static void bench_batch_env(int numEnvs, Uint64 numSteps, int numThreads)
+{
+    JobSystem jobs;
+    job_system_create(jobs, numThreads);
+    
+    World level;
+    world_create(level, BENCH_WIDTH, BENCH_HEIGHT);
+    
+    BatchEnv env;
+    batch_env_create(env, level, numEnvs, 12345);
+    
+    // A fresh random action per env every step, from a table made up front and cycled through so
+    // the timing is just the envs
+    gRandomState = 12345;
+    std::vector<int> actions(BENCH_BATCH_ACTION_STEPS * numEnvs);
+    for(size_t i = 0; i < actions.size(); ++i)
+    {
+        actions[i] = bench_random(-1, 1);
+    }
+    
+    Uint64 numEpisodes = 0;
+    Uint64 allocations = heap_allocation_count();
+    Uint64 start = SDL_GetPerformanceCounter();
+    
+    for(Uint64 i = 0; i < numSteps; ++i)
+    {
+        batch_env_step(env, &actions[(i % BENCH_BATCH_ACTION_STEPS) * numEnvs], jobs);
+        
+        for(int j = 0; j < numEnvs; ++j)
+        {
+            numEpisodes += env.dones[j];
+        }
+    }
+    
+    double seconds = bench_seconds_since(start);
+    allocations = heap_allocation_count() - allocations;
+    
+    printf("%2d threads: %d envs, %llu steps in %.3f s, %.0f env steps/s, %llu episodes, %llu heap allocations\n", numThreads, numEnvs,
+           (unsigned long long)numSteps, seconds, (double)numEnvs * numSteps / seconds, (unsigned long long)numEpisodes, (unsigned long long)allocations);
+    
+    batch_env_destroy(env);
+    world_destroy(level);
+    job_system_destroy(jobs);
+}
+
+#undef main
+int main(int argc, char *argv[])
+{
+    Uint64 numTicks = 10000000;
+    if(argc > 1)
+    {
+        numTicks = strtoull(argv[1], NULL, 10);
+    }
+    
+    printf("block overlap kernel: %s\n", block_overlap_kernel_name());
+    
+    bench_single_ball(numTicks);
+    
+    // Keep the total ball ticks per run about the same so each size takes similar time
+    const int poolSizes[] = {1000, 10000, 100000};
+    for(int i = 0; i < 3; ++i)
+    {
+        Uint64 poolTicks = numTicks / poolSizes[i];
+        if(poolTicks < 10) poolTicks = 10;
+        
+        bench_ball_pool(poolSizes[i], poolTicks);
+    }
+    
+    if(!bench_snapshot(1, 100000)) return 1;
+    if(!bench_snapshot(1000, 10000)) return 1;
+    if(!bench_snapshot(100000, 100)) return 1;
+    
+    int maxThreads = (int)std::thread::hardware_concurrency();
+    if(maxThreads < 1) maxThreads = 1;
+    if(maxThreads > JOB_MAX_THREADS) maxThreads = JOB_MAX_THREADS;
+    
+    Uint64 scalingTicks = numTicks / 100000;
+    if(scalingTicks < 10) scalingTicks = 10;
+    
+    for(int numThreads = 1; ; numThreads *= 2)
+    {
+        if(numThreads > maxThreads) numThreads = maxThreads;
+        
+        bench_thread_scaling(100000, scalingTicks, numThreads);
+        
+        if(numThreads == maxThreads) break;
+    }
+    
+    Uint64 batchSteps = numTicks / 4096;
+    if(batchSteps < 10) batchSteps = 10;
+    
+    for(int numThreads = 1; ; numThreads *= 2)
+    {
+        if(numThreads > maxThreads) numThreads = maxThreads;
+        
+        bench_batch_env(4096, batchSteps, numThreads);
+        
+        if(numThreads == maxThreads) break;
+    }
+    
+    return 0;
+}
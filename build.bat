@@ -7,10 +7,21 @@ pushd build
 REM Zi -- full debug info
 REM I -- include folder
 REM SUBSYSTEM:CONSOLE -- sends output to the console window (default is SUBSYSTEM:WINDOWS)
+REM DBREAKOUT_PROFILE -- per-frame profiler scopes and overlay, the bench is built without them
 
 set CompilerFlags= -Zi -I ../include/
+set ProfileFlags= -DBREAKOUT_PROFILE
 set LinkerFlags= /SUBSYSTEM:CONSOLE /LIBPATH:../lib/x64/ SDL2.lib SDL2_image.lib SDL2_ttf.lib
 
-cl %CompilerFlags% ../main.cpp /link %LinkerFlags%
+cl %CompilerFlags% %ProfileFlags% ../main.cpp ../simulation.cpp ../arena.cpp ../collision_simd.cpp ../jobs.cpp ../replay.cpp ../level.cpp ../text.cpp ../render.cpp ../pacer.cpp ../histogram.cpp ../profile.cpp ../trace.cpp ../alloc_count.cpp /link %LinkerFlags%
+cl %CompilerFlags% ../bench_simulation.cpp ../simulation.cpp ../arena.cpp ../collision_simd.cpp ../jobs.cpp ../snapshot.cpp ../batch_env.cpp ../profile.cpp ../trace.cpp ../alloc_count.cpp /link %LinkerFlags%
+cl %CompilerFlags% ../render_regression.cpp ../render.cpp ../simulation.cpp ../arena.cpp ../collision_simd.cpp ../jobs.cpp ../profile.cpp ../trace.cpp /link %LinkerFlags%
+cl %CompilerFlags% ../replay_test.cpp ../replay.cpp ../simulation.cpp ../arena.cpp ../collision_simd.cpp ../jobs.cpp ../profile.cpp ../trace.cpp /link %LinkerFlags%
+cl %CompilerFlags% ../bench_render.cpp ../render.cpp ../simulation.cpp ../arena.cpp ../collision_simd.cpp ../jobs.cpp ../profile.cpp ../trace.cpp /link %LinkerFlags%
+cl %CompilerFlags% ../level_compiler.cpp /link %LinkerFlags%
+
+REM levels/*.txt -> build/levels/*.level
+IF NOT EXIST levels mkdir levels
+for %%f in (../levels/*.txt) do level_compiler.exe ../levels/%%f levels/%%~nf.level
 
 popd
\ No newline at end of file
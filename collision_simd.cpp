@@ -0,0 +1,128 @@
+#include "simulation.h"
+
+#include "SDL_cpuinfo.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BREAKOUT_X86 1
+#include <immintrin.h>
+#endif
+
+// NOTE(chris) MSVC lets us use any intrinsic anywhere, gcc/clang need the function tagged with the target
+#if defined(BREAKOUT_X86) && (defined(__GNUC__) || defined(__clang__))
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+// A block is a broad-phase hit when it overlaps the query rect (edges touching counts):
+//     x <= queryRight && x + w >= queryLeft && y <= queryBottom && y + h >= queryTop
+
+static Uint64 block_overlap_word_scalar(BlockStore& store, int word, SDL_Rect query)
+{
+    int left = query.x;
+    int right = query.x + query.w;
+    int top = query.y;
+    int bottom = query.y + query.h;
+    
+    Uint64 mask = 0;
+    int first = word * 64;
+    for(int lane = 0; lane < 64; ++lane)
+    {
+        int i = first + lane;
+        bool hit = store.x[i] <= right && store.x[i] + store.w[i] >= left &&
+            store.y[i] <= bottom && store.y[i] + store.h[i] >= top;
+        
+        mask |= (Uint64)hit << lane;
+    }
+    
+    return mask;
+}
+
+#ifdef BREAKOUT_X86
+TARGET_SSE2 static Uint64 block_overlap_word_sse2(BlockStore& store, int word, SDL_Rect query)
+{
+    // x + w > left - 1 is the same as x + w >= left, SSE2 only has greater than
+    __m128i left = _mm_set1_epi32(query.x - 1);
+    __m128i right = _mm_set1_epi32(query.x + query.w);
+    __m128i top = _mm_set1_epi32(query.y - 1);
+    __m128i bottom = _mm_set1_epi32(query.y + query.h);
+    
+    Uint64 mask = 0;
+    int first = word * 64;
+    for(int lane = 0; lane < 64; lane += 4)
+    {
+        int i = first + lane;
+        __m128i x = _mm_loadu_si128((__m128i*)(store.x + i));
+        __m128i y = _mm_loadu_si128((__m128i*)(store.y + i));
+        __m128i w = _mm_loadu_si128((__m128i*)(store.w + i));
+        __m128i h = _mm_loadu_si128((__m128i*)(store.h + i));
+        
+        __m128i hitX = _mm_andnot_si128(_mm_cmpgt_epi32(x, right), _mm_cmpgt_epi32(_mm_add_epi32(x, w), left));
+        __m128i hitY = _mm_andnot_si128(_mm_cmpgt_epi32(y, bottom), _mm_cmpgt_epi32(_mm_add_epi32(y, h), top));
+        __m128i hit = _mm_and_si128(hitX, hitY);
+        
+        mask |= (Uint64)_mm_movemask_ps(_mm_castsi128_ps(hit)) << lane;
+    }
+    
+    return mask;
+}
+
+TARGET_AVX2 static Uint64 block_overlap_word_avx2(BlockStore& store, int word, SDL_Rect query)
+{
+    __m256i left = _mm256_set1_epi32(query.x - 1);
+    __m256i right = _mm256_set1_epi32(query.x + query.w);
+    __m256i top = _mm256_set1_epi32(query.y - 1);
+    __m256i bottom = _mm256_set1_epi32(query.y + query.h);
+    
+    Uint64 mask = 0;
+    int first = word * 64;
+    for(int lane = 0; lane < 64; lane += 8)
+    {
+        int i = first + lane;
+        __m256i x = _mm256_loadu_si256((__m256i*)(store.x + i));
+        __m256i y = _mm256_loadu_si256((__m256i*)(store.y + i));
+        __m256i w = _mm256_loadu_si256((__m256i*)(store.w + i));
+        __m256i h = _mm256_loadu_si256((__m256i*)(store.h + i));
+        
+        __m256i hitX = _mm256_andnot_si256(_mm256_cmpgt_epi32(x, right), _mm256_cmpgt_epi32(_mm256_add_epi32(x, w), left));
+        __m256i hitY = _mm256_andnot_si256(_mm256_cmpgt_epi32(y, bottom), _mm256_cmpgt_epi32(_mm256_add_epi32(y, h), top));
+        __m256i hit = _mm256_and_si256(hitX, hitY);
+        
+        mask |= (Uint64)(Uint32)_mm256_movemask_ps(_mm256_castsi256_ps(hit)) << lane;
+    }
+    
+    return mask;
+}
+#endif
+
+typedef Uint64 BlockOverlapWordFunc(BlockStore& store, int word, SDL_Rect query);
+
+static BlockOverlapWordFunc* block_overlap_select()
+{
+#ifdef BREAKOUT_X86
+    if(SDL_HasAVX2()) return block_overlap_word_avx2;
+    if(SDL_HasSSE2()) return block_overlap_word_sse2;
+#endif
+    
+    return block_overlap_word_scalar;
+}
+
+Uint64 block_overlap_word(BlockStore& store, int word, SDL_Rect query)
+{
+    static BlockOverlapWordFunc* overlapWord = block_overlap_select();
+    
+    return overlapWord(store, word, query);
+}
+
+const char* block_overlap_kernel_name()
+{
+#ifdef BREAKOUT_X86
+    BlockOverlapWordFunc* overlapWord = block_overlap_select();
+    if(overlapWord == block_overlap_word_avx2) return "avx2";
+    if(overlapWord == block_overlap_word_sse2) return "sse2";
+#endif
+    
+    return "scalar";
+}
@@ -0,0 +1,101 @@
+#include "histogram.h"
+
+#include <stdio.h>
+
+static int histogram_msb(Uint32 value)
+{
+    int msb = 0;
+    while(value >>= 1) ++msb;
+    
+    return msb;
+}
+
+int histogram_bucket(Uint32 value)
+{
+    if(value > HISTOGRAM_MAX_VALUE) value = HISTOGRAM_MAX_VALUE;
+    if(value < HISTOGRAM_SUB_BUCKETS * 2) return (int)value;
+    
+    // Keep the leading 1 and the HISTOGRAM_SUB_BITS below it
+    int shift = histogram_msb(value) - HISTOGRAM_SUB_BITS;
+    return shift * HISTOGRAM_SUB_BUCKETS + (int)(value >> shift);
+}
+
+Uint32 histogram_bucket_max(int bucket)
+{
+    if(bucket < HISTOGRAM_SUB_BUCKETS * 2) return (Uint32)bucket;
+    
+    int shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+    Uint32 top = (Uint32)(bucket % HISTOGRAM_SUB_BUCKETS + HISTOGRAM_SUB_BUCKETS);
+    
+    return ((top + 1) << shift) - 1;
+}
+
+void histogram_add(Histogram& histogram, Uint32 value)
+{
+    ++histogram.counts[histogram_bucket(value)];
+    ++histogram.total;
+}
+
+void histogram_remove(Histogram& histogram, Uint32 value)
+{
+    --histogram.counts[histogram_bucket(value)];
+    --histogram.total;
+}
+
+Uint32 histogram_percentile(Histogram& histogram, double percentile)
+{
+    if(histogram.total == 0) return 0;
+    
+    // Rank of the sample we want, 1 based, rounded up so p100 is the last sample
+    Uint64 rank = (Uint64)(percentile / 100.0 * histogram.total + 0.999999);
+    if(rank < 1) rank = 1;
+    if(rank > histogram.total) rank = histogram.total;
+    
+    Uint64 seen = 0;
+    for(int bucket = 0; bucket < HISTOGRAM_NUM_BUCKETS; ++bucket)
+    {
+        seen += histogram.counts[bucket];
+        if(seen >= rank) return histogram_bucket_max(bucket);
+    }
+    
+    return HISTOGRAM_MAX_VALUE;
+}
+
+void frame_stats_add(FrameStats& stats, Uint32 frameMicros)
+{
+    if(stats.numRecent == FRAME_STATS_WINDOW)
+    {
+        histogram_remove(stats.window, stats.recent[stats.recentIndex]);
+    }
+    else
+    {
+        ++stats.numRecent;
+    }
+    
+    stats.recent[stats.recentIndex] = frameMicros;
+    stats.recentIndex = (stats.recentIndex + 1) % FRAME_STATS_WINDOW;
+    
+    histogram_add(stats.window, frameMicros);
+    histogram_add(stats.lifetime, frameMicros);
+}
+
+void frame_stats_dump(FrameStats& stats)
+{
+    Histogram& lifetime = stats.lifetime;
+    
+    printf("Frame times over %llu frames (ms): p50 %.2f p95 %.2f p99 %.2f max %.2f\n", (unsigned long long)lifetime.total,
+           histogram_percentile(lifetime, 50) / 1000.0, histogram_percentile(lifetime, 95) / 1000.0,
+           histogram_percentile(lifetime, 99) / 1000.0, histogram_percentile(lifetime, 100) / 1000.0);
+    
+    Uint64 seen = 0;
+    for(int bucket = 0; bucket < HISTOGRAM_NUM_BUCKETS; ++bucket)
+    {
+        if(lifetime.counts[bucket] == 0) continue;
+        
+        seen += lifetime.counts[bucket];
+        Uint32 low = bucket ? histogram_bucket_max(bucket - 1) + 1 : 0;
+        
+        printf("  %8.2f - %8.2f ms: %10llu  %6.2f%%\n", low / 1000.0, histogram_bucket_max(bucket) / 1000.0,
+               (unsigned long long)lifetime.counts[bucket], 100.0 * seen / lifetime.total);
+    }
+}
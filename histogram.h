@@ -0,0 +1,50 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include "SDL_stdinc.h"
+
+// HDR style log-linear histogram of microsecond values: exact below 256 us, then every power of two
+// split into 128 buckets, so any value is known to within 1% in a fixed 2560 counters up to ~67 s.
+const int HISTOGRAM_SUB_BITS = 7;
+const int HISTOGRAM_SUB_BUCKETS = 1 << HISTOGRAM_SUB_BITS;
+const int HISTOGRAM_MAX_BITS = 26;
+const int HISTOGRAM_NUM_BUCKETS = (HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS;
+const Uint32 HISTOGRAM_MAX_VALUE = (1u << HISTOGRAM_MAX_BITS) - 1;
+
+struct Histogram
+{
+    Uint64 counts[HISTOGRAM_NUM_BUCKETS];
+    Uint64 total;
+};
+
+int histogram_bucket(Uint32 value);
+
+// Largest value that lands in bucket, percentiles report this so they never under-state a hitch
+Uint32 histogram_bucket_max(int bucket);
+
+void histogram_add(Histogram& histogram, Uint32 value);
+void histogram_remove(Histogram& histogram, Uint32 value);
+
+// percentile in 0 .. 100, 100 gives the max. 0 if the histogram is empty.
+Uint32 histogram_percentile(Histogram& histogram, double percentile);
+
+// Frames older than this fall out of the window stats
+const int FRAME_STATS_WINDOW = 600;
+
+// Frame times over the last FRAME_STATS_WINDOW frames and over the whole run
+struct FrameStats
+{
+    Histogram window;
+    Histogram lifetime;
+    
+    Uint32 recent[FRAME_STATS_WINDOW]; // ring of the frame times in window
+    int recentIndex;
+    int numRecent;
+};
+
+void frame_stats_add(FrameStats& stats, Uint32 frameMicros);
+
+// Prints the lifetime percentiles and every non empty bucket
+void frame_stats_dump(FrameStats& stats);
+
+#endif
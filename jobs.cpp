@@ -0,0 +1,144 @@
+#include "jobs.h"
+
+static bool job_pop(JobQueue& queue, Job& job)
+{
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if(queue.jobs.empty()) return false;
+    
+    job = queue.jobs.back();
+    queue.jobs.pop_back();
+    return true;
+}
+
+static bool job_steal(JobQueue& queue, Job& job)
+{
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if(queue.jobs.empty()) return false;
+    
+    job = queue.jobs.front();
+    queue.jobs.pop_front();
+    return true;
+}
+
+// Own queue first, then go round the others starting with the next thread along
+static bool job_find(JobSystem& jobs, int threadIndex, Job& job)
+{
+    if(job_pop(jobs.queues[threadIndex], job)) return true;
+    
+    for(int i = 1; i < jobs.numThreads; ++i)
+    {
+        if(job_steal(jobs.queues[(threadIndex + i) % jobs.numThreads], job)) return true;
+    }
+    
+    return false;
+}
+
+static void job_run(JobSystem& jobs, Job& job)
+{
+    jobs.queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    
+    job.func(job.data, job.begin, job.end);
+    
+    if(jobs.pendingJobs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        // NOTE(chris) take the lock so the caller can't miss this between checking and sleeping
+        std::lock_guard<std::mutex> lock(jobs.wakeMutex);
+        jobs.wake.notify_all();
+    }
+}
+
+static void job_worker(JobSystem& jobs, int threadIndex)
+{
+    for(;;)
+    {
+        Job job;
+        if(job_find(jobs, threadIndex, job))
+        {
+            job_run(jobs, job);
+            continue;
+        }
+        
+        std::unique_lock<std::mutex> lock(jobs.wakeMutex);
+        jobs.wake.wait(lock, [&] { return jobs.quit.load() || jobs.queuedJobs.load() > 0; });
+        
+        if(jobs.quit.load()) return;
+    }
+}
+
+void job_system_create(JobSystem& jobs, int numThreads)
+{
+    if(numThreads <= 0) numThreads = (int)std::thread::hardware_concurrency();
+    if(numThreads <= 0) numThreads = 1;
+    if(numThreads > JOB_MAX_THREADS) numThreads = JOB_MAX_THREADS;
+    
+    jobs.numThreads = numThreads;
+    jobs.queuedJobs = 0;
+    jobs.pendingJobs = 0;
+    jobs.quit = false;
+    
+    for(int i = 1; i < numThreads; ++i)
+    {
+        jobs.workers.push_back(std::thread(job_worker, std::ref(jobs), i));
+    }
+}
+
+void job_system_destroy(JobSystem& jobs)
+{
+    {
+        std::lock_guard<std::mutex> lock(jobs.wakeMutex);
+        jobs.quit = true;
+    }
+    jobs.wake.notify_all();
+    
+    for(size_t i = 0; i < jobs.workers.size(); ++i)
+    {
+        jobs.workers[i].join();
+    }
+    
+    jobs.workers.clear();
+}
+
+void job_parallel_for(JobSystem& jobs, int count, int batchSize, JobFunc* func, void* data)
+{
+    if(count <= 0) return;
+    
+    // Nobody to share with, skip the queues
+    if(jobs.numThreads == 1 || count <= batchSize)
+    {
+        func(data, 0, count);
+        return;
+    }
+    
+    int numJobs = (count + batchSize - 1) / batchSize;
+    jobs.pendingJobs.fetch_add(numJobs, std::memory_order_relaxed);
+    
+    // Deal the batches out round robin so every thread starts with local work
+    for(int i = 0; i < numJobs; ++i)
+    {
+        Job job;
+        job.func = func;
+        job.data = data;
+        job.begin = i * batchSize;
+        job.end = job.begin + batchSize < count ? job.begin + batchSize : count;
+        
+        JobQueue& queue = jobs.queues[i % jobs.numThreads];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(job);
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(jobs.wakeMutex);
+        jobs.queuedJobs.fetch_add(numJobs, std::memory_order_release);
+    }
+    jobs.wake.notify_all();
+    
+    // Help out instead of just waiting
+    Job job;
+    while(job_find(jobs, 0, job))
+    {
+        job_run(jobs, job);
+    }
+    
+    std::unique_lock<std::mutex> lock(jobs.wakeMutex);
+    jobs.wake.wait(lock, [&] { return jobs.pendingJobs.load() == 0; });
+}
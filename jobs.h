@@ -0,0 +1,53 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+const int JOB_MAX_THREADS = 64;
+
+// Runs func over [begin, end) of whatever data points at
+typedef void JobFunc(void* data, int begin, int end);
+
+struct Job
+{
+    JobFunc* func;
+    void* data;
+    int begin;
+    int end;
+};
+
+// One queue per thread, the owner pops from the back (newest, still warm in cache) and idle
+// threads steal from the front of everyone else's. Thread 0 is whoever calls job_parallel_for.
+struct JobQueue
+{
+    std::mutex mutex;
+    std::deque<Job> jobs;
+};
+
+struct JobSystem
+{
+    int numThreads;
+    JobQueue queues[JOB_MAX_THREADS];
+    std::vector<std::thread> workers;
+    
+    std::atomic<int> queuedJobs;  // sitting in a queue, workers sleep while this is 0
+    std::atomic<int> pendingJobs; // queued or running, job_parallel_for returns when this hits 0
+    std::atomic<bool> quit;
+    
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+};
+
+// numThreads counts the calling thread, 0 means one per hardware thread
+void job_system_create(JobSystem& jobs, int numThreads);
+void job_system_destroy(JobSystem& jobs);
+
+// Splits [0, count) into batches of batchSize, runs them across all threads and waits for them
+void job_parallel_for(JobSystem& jobs, int count, int batchSize, JobFunc* func, void* data);
+
+#endif
@@ -0,0 +1,215 @@
+#include "level.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static bool level_array_fits(LevelFile& level, Uint32 offset, size_t size)
+{
+    return offset % LEVEL_ALIGNMENT == 0 && offset <= level.size && size <= level.size - offset;
+}
+
+static bool level_file_validate(LevelFile& level, const char* path)
+{
+    if(level.size < sizeof(LevelHeader))
+    {
+        printf("Level %s is too short to have a header!\n", path);
+        return false;
+    }
+    
+    const LevelHeader& header = level_header(level);
+    if(header.magic != LEVEL_MAGIC || header.version != LEVEL_VERSION)
+    {
+        printf("%s isn't a version %u level!\n", path, LEVEL_VERSION);
+        return false;
+    }
+    
+    size_t blockSlots = (size_t)header.numBlockWords * 64;
+    
+    bool valid = header.fileSize == level.size &&
+        header.width > 0 && header.width <= LEVEL_MAX_SIZE &&
+        header.height > 0 && header.height <= LEVEL_MAX_SIZE &&
+        header.numColors >= 0 && header.numColors <= WORLD_MAX_COLORS &&
+        header.numBlocks >= 0 && header.numBlockWords == (header.numBlocks + 63) / 64 &&
+        level_array_fits(level, header.colorsOffset, header.numColors * sizeof(SDL_Color)) &&
+        level_array_fits(level, header.xOffset, blockSlots * sizeof(int)) &&
+        level_array_fits(level, header.yOffset, blockSlots * sizeof(int)) &&
+        level_array_fits(level, header.wOffset, blockSlots * sizeof(int)) &&
+        level_array_fits(level, header.hOffset, blockSlots * sizeof(int)) &&
+        level_array_fits(level, header.colorOffset, blockSlots) &&
+        level_array_fits(level, header.hitPointsOffset, blockSlots);
+    
+    if(!valid)
+    {
+        printf("Level %s is corrupt!\n", path);
+    }
+    
+    return valid;
+}
+
+#ifdef _WIN32
+bool level_file_map(LevelFile& level, const char* path)
+{
+    level = LevelFile();
+    
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        printf("Unable to open level %s!\n", path);
+        return false;
+    }
+    
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    const Uint8* data = mapping ? (const Uint8*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if(data == NULL)
+    {
+        printf("Unable to map level %s!\n", path);
+        if(mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    
+    level.data = data;
+    level.size = (size_t)size.QuadPart;
+    level.file = file;
+    level.mapping = mapping;
+    
+    if(!level_file_validate(level, path))
+    {
+        level_file_unmap(level);
+        return false;
+    }
+    
+    return true;
+}
+
+void level_file_unmap(LevelFile& level)
+{
+    if(level.data) UnmapViewOfFile(level.data);
+    if(level.mapping) CloseHandle(level.mapping);
+    if(level.file) CloseHandle(level.file);
+    
+    level = LevelFile();
+}
+#else
+bool level_file_map(LevelFile& level, const char* path)
+{
+    level = LevelFile();
+    
+    int file = open(path, O_RDONLY);
+    if(file < 0)
+    {
+        printf("Unable to open level %s!\n", path);
+        return false;
+    }
+    
+    struct stat info;
+    void* data = MAP_FAILED;
+    if(fstat(file, &info) == 0 && info.st_size > 0)
+    {
+        data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    }
+    
+    // The mapping keeps the file alive on its own
+    close(file);
+    
+    if(data == MAP_FAILED)
+    {
+        printf("Unable to map level %s!\n", path);
+        return false;
+    }
+    
+    level.data = (const Uint8*)data;
+    level.size = (size_t)info.st_size;
+    
+    if(!level_file_validate(level, path))
+    {
+        level_file_unmap(level);
+        return false;
+    }
+    
+    return true;
+}
+
+void level_file_unmap(LevelFile& level)
+{
+    if(level.data) munmap((void*)level.data, level.size);
+    
+    level = LevelFile();
+}
+#endif
+
+bool world_create_from_level(World& world, LevelFile& level, Arena* levelArena)
+{
+    const LevelHeader& header = level_header(level);
+    
+    // Color indices and rects outside the play area would index out of bounds later (palette and
+    // grid) or overflow x + w, check them before touching the world. The size is already bounded.
+    const Uint8* colors = level.data + header.colorOffset;
+    const int* x = (const int*)(level.data + header.xOffset);
+    const int* y = (const int*)(level.data + header.yOffset);
+    const int* w = (const int*)(level.data + header.wOffset);
+    const int* h = (const int*)(level.data + header.hOffset);
+    for(int i = 0; i < header.numBlocks; ++i)
+    {
+        if(colors[i] >= header.numColors || x[i] < 0 || y[i] < 0 || w[i] <= 0 || h[i] <= 0 ||
+           w[i] > header.width - x[i] || h[i] > header.height - y[i])
+        {
+            printf("Level block %d is invalid!\n", i);
+            return false;
+        }
+    }
+    
+    world_create_empty(world, header.width, header.height, levelArena);
+    
+    const SDL_Color* levelColors = (const SDL_Color*)(level.data + header.colorsOffset);
+    for(int i = 0; i < header.numColors; ++i)
+    {
+        world.colors[i] = levelColors[i];
+    }
+    world.numColors = header.numColors;
+    
+    int capacity = header.numBlockWords * 64;
+    
+    BlockStore& store = world.blocks;
+    store.numBlocks = header.numBlocks;
+    store.capacity = capacity;
+    store.borrowed = true;
+    store.x = (int*)x;
+    store.y = (int*)y;
+    store.w = (int*)w;
+    store.h = (int*)h;
+    store.color = (Uint8*)colors;
+    
+    // Hit points go down as blocks are hit, so they're the one block array that's copied
+    store.hitPoints = arena_new_array<Uint8>(levelArena, capacity);
+    memcpy(store.hitPoints, level.data + header.hitPointsOffset, capacity);
+    
+    store.active = arena_new_array<Uint64>(levelArena, header.numBlockWords);
+    for(int i = 0; i < header.numBlocks; ++i)
+    {
+        if(store.hitPoints[i] > 0) store.active[i >> 6] |= (Uint64)1 << (i & 63);
+    }
+    
+    // Same cell size rule as block_row_create, the smallest block
+    for(int i = 0; i < header.numBlocks; ++i)
+    {
+        if(world.grid.cellWidth == 0 || store.w[i] < world.grid.cellWidth) world.grid.cellWidth = store.w[i];
+        if(world.grid.cellHeight == 0 || store.h[i] < world.grid.cellHeight) world.grid.cellHeight = store.h[i];
+    }
+    
+    block_grid_build(world);
+    
+    return true;
+}
@@ -0,0 +1,73 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include "simulation.h"
+
+// Compiled level file. Written by level_compiler from a text source (see levels/default.txt) and
+// mapped straight into memory by the game, the block arrays are used in place as the world's
+// BlockStore so loading a level is a map and a single pass to set up the alive bits.
+//
+//     LevelHeader
+//     SDL_Color colors[numColors]
+//     int       x, y, w, h[numBlockWords * 64]   (zero padded to whole words like BlockStore)
+//     Uint8     color, hitPoints[numBlockWords * 64]
+//
+// Every array starts on a LEVEL_ALIGNMENT boundary, offsets are from the start of the file.
+// Native byte order, the magic won't match on a machine with the other one.
+
+const Uint32 LEVEL_MAGIC = 0x564C4B42; // "BKLV"
+const Uint32 LEVEL_VERSION = 1;
+const int LEVEL_ALIGNMENT = 64;
+
+// Largest play area width and height, every block has to fit inside the play area. Keeps block
+// extents and the grid's cell count (1 px blocks over the whole area) well inside an int.
+const int LEVEL_MAX_SIZE = 4096;
+
+struct LevelHeader
+{
+    Uint32 magic;
+    Uint32 version;
+    Uint32 id; // recorded in replays
+    Uint32 fileSize;
+    
+    int width;
+    int height;
+    
+    int numColors;
+    int numBlocks;
+    int numBlockWords;
+    
+    Uint32 colorsOffset;
+    Uint32 xOffset;
+    Uint32 yOffset;
+    Uint32 wOffset;
+    Uint32 hOffset;
+    Uint32 colorOffset;
+    Uint32 hitPointsOffset;
+};
+
+struct LevelFile
+{
+    const Uint8* data;
+    size_t size;
+
+#ifdef _WIN32
+    void* file;
+    void* mapping;
+#endif
+};
+
+inline const LevelHeader& level_header(LevelFile& level)
+{
+    return *(const LevelHeader*)level.data;
+}
+
+// Maps the file read only and checks the header, every array has to lie inside the file
+bool level_file_map(LevelFile& level, const char* path);
+void level_file_unmap(LevelFile& level);
+
+// The world borrows the level's block arrays, so the level has to stay mapped until world_destroy.
+// What it does allocate comes out of levelArena when there is one, like world_create.
+bool world_create_from_level(World& world, LevelFile& level, Arena* levelArena = NULL);
+
+#endif
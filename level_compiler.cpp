@@ -0,0 +1,251 @@
+// Compiles a level text source into the packed binary the game maps (see level.h).
+//
+//     level_compiler <source.txt> <output.level>
+//
+// Source format, one directive per line, # starts a comment:
+//
+//     id <n>                                          recorded in replays
+//     size <width> <height>                           play area, up to LEVEL_MAX_SIZE, before any blocks
+//     color <index> <r> <g> <b>                       palette entry, up to WORLD_MAX_COLORS
+//     row <y> <width> <height> <spacing> <color> <hitPoints>
+//                                                     as many blocks as fit across the width, spacing apart
+//     block <x> <y> <width> <height> <color> <hitPoints>
+//
+// Every block has to fit inside the play area.
+
+#include "level.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+struct LevelSource
+{
+    Uint32 id;
+    int width;
+    int height;
+    
+    SDL_Color colors[WORLD_MAX_COLORS];
+    int numColors;
+    
+    std::vector<SDL_Rect> rects;
+    std::vector<Uint8> colorIndices;
+    std::vector<Uint8> hitPoints;
+};
+
+static bool level_source_add_block(LevelSource& source, SDL_Rect rect, int color, int hitPoints, const char* path, int line)
+{
+    if(source.width <= 0)
+    {
+        printf("%s:%d: blocks need the size set first\n", path, line);
+        return false;
+    }
+    
+    if(rect.x < 0 || rect.y < 0 || rect.w <= 0 || rect.h <= 0)
+    {
+        printf("%s:%d: blocks need a positive size and can't start off the top or left\n", path, line);
+        return false;
+    }
+    
+    // Same bound as the loader, written so x + w can't overflow
+    if(rect.w > source.width - rect.x || rect.h > source.height - rect.y)
+    {
+        printf("%s:%d: block %d %d %d %d doesn't fit in the %dx%d play area\n", path, line, rect.x, rect.y, rect.w, rect.h,
+               source.width, source.height);
+        return false;
+    }
+    
+    if(color < 0 || color >= source.numColors)
+    {
+        printf("%s:%d: color %d hasn't been defined\n", path, line, color);
+        return false;
+    }
+    
+    if(hitPoints < 1 || hitPoints > 255)
+    {
+        printf("%s:%d: hit points have to be 1 to 255\n", path, line);
+        return false;
+    }
+    
+    source.rects.push_back(rect);
+    source.colorIndices.push_back((Uint8)color);
+    source.hitPoints.push_back((Uint8)hitPoints);
+    
+    return true;
+}
+
+static bool level_source_parse(LevelSource& source, const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if(file == NULL)
+    {
+        printf("Unable to open %s!\n", path);
+        return false;
+    }
+    
+    bool success = true;
+    char text[256];
+    
+    for(int line = 1; success && fgets(text, sizeof(text), file); ++line)
+    {
+        char* comment = strchr(text, '#');
+        if(comment) *comment = '\0';
+        
+        char directive[16];
+        if(sscanf(text, "%15s", directive) != 1) continue;
+        
+        int a, b, c, d, e, f;
+        if(strcmp(directive, "id") == 0 && sscanf(text, "%*s %d", &a) == 1)
+        {
+            source.id = (Uint32)a;
+        }
+        else if(strcmp(directive, "size") == 0 && sscanf(text, "%*s %d %d", &a, &b) == 2)
+        {
+            if(a <= 0 || b <= 0 || a > LEVEL_MAX_SIZE || b > LEVEL_MAX_SIZE || !source.rects.empty())
+            {
+                printf("%s:%d: size has to come before any blocks and be 1 to %d each way\n", path, line, LEVEL_MAX_SIZE);
+                success = false;
+                break;
+            }
+            
+            source.width = a;
+            source.height = b;
+        }
+        else if(strcmp(directive, "color") == 0 && sscanf(text, "%*s %d %d %d %d", &a, &b, &c, &d) == 4)
+        {
+            if(a != source.numColors || a >= WORLD_MAX_COLORS)
+            {
+                printf("%s:%d: colors have to be numbered 0, 1, 2 ... up to %d\n", path, line, WORLD_MAX_COLORS - 1);
+                success = false;
+                break;
+            }
+            
+            SDL_Color color = {(Uint8)b, (Uint8)c, (Uint8)d, 0xFF};
+            source.colors[source.numColors++] = color;
+        }
+        else if(strcmp(directive, "row") == 0 && sscanf(text, "%*s %d %d %d %d %d %d", &a, &b, &c, &d, &e, &f) == 6)
+        {
+            if(source.width <= 0 || b <= 0 || d < 0)
+            {
+                printf("%s:%d: row needs the size set first, a positive block width and no negative spacing\n", path, line);
+                success = false;
+                break;
+            }
+            
+            // Unlike block_row_create the spacing is counted too, so the last block never hangs off the edge
+            int numBlocks = (source.width + d) / (b + d);
+            for(int i = 0; success && i < numBlocks; ++i)
+            {
+                SDL_Rect rect = {i * (b + d), a, b, c};
+                success = level_source_add_block(source, rect, e, f, path, line);
+            }
+        }
+        else if(strcmp(directive, "block") == 0 && sscanf(text, "%*s %d %d %d %d %d %d", &a, &b, &c, &d, &e, &f) == 6)
+        {
+            SDL_Rect rect = {a, b, c, d};
+            success = level_source_add_block(source, rect, e, f, path, line);
+        }
+        else
+        {
+            printf("%s:%d: can't make sense of '%s'\n", path, line, directive);
+            success = false;
+        }
+    }
+    
+    fclose(file);
+    
+    if(success && (source.width <= 0 || source.height <= 0))
+    {
+        printf("%s: needs a size\n", path);
+        success = false;
+    }
+    
+    return success;
+}
+
+static Uint32 level_append(std::vector<Uint8>& out, const void* data, size_t size)
+{
+    out.resize((out.size() + LEVEL_ALIGNMENT - 1) / LEVEL_ALIGNMENT * LEVEL_ALIGNMENT);
+    
+    Uint32 offset = (Uint32)out.size();
+    out.insert(out.end(), (const Uint8*)data, (const Uint8*)data + size);
+    
+    return offset;
+}
+
+static void level_compile(LevelSource& source, std::vector<Uint8>& out)
+{
+    int numBlocks = (int)source.rects.size();
+    int numBlockWords = (numBlocks + 63) / 64;
+    int slots = numBlockWords * 64;
+    
+    // Zero padded to whole words, the broad-phase reads them
+    std::vector<int> x(slots), y(slots), w(slots), h(slots);
+    std::vector<Uint8> colors(slots), hitPoints(slots);
+    for(int i = 0; i < numBlocks; ++i)
+    {
+        x[i] = source.rects[i].x;
+        y[i] = source.rects[i].y;
+        w[i] = source.rects[i].w;
+        h[i] = source.rects[i].h;
+        colors[i] = source.colorIndices[i];
+        hitPoints[i] = source.hitPoints[i];
+    }
+    
+    LevelHeader header = {};
+    header.magic = LEVEL_MAGIC;
+    header.version = LEVEL_VERSION;
+    header.id = source.id;
+    header.width = source.width;
+    header.height = source.height;
+    header.numColors = source.numColors;
+    header.numBlocks = numBlocks;
+    header.numBlockWords = numBlockWords;
+    
+    out.clear();
+    level_append(out, &header, sizeof(header));
+    
+    header.colorsOffset = level_append(out, source.colors, source.numColors * sizeof(SDL_Color));
+    header.xOffset = level_append(out, x.data(), slots * sizeof(int));
+    header.yOffset = level_append(out, y.data(), slots * sizeof(int));
+    header.wOffset = level_append(out, w.data(), slots * sizeof(int));
+    header.hOffset = level_append(out, h.data(), slots * sizeof(int));
+    header.colorOffset = level_append(out, colors.data(), slots);
+    header.hitPointsOffset = level_append(out, hitPoints.data(), slots);
+    header.fileSize = (Uint32)out.size();
+    
+    memcpy(out.data(), &header, sizeof(header));
+}
+
+#undef main
+int main(int argc, char *argv[])
+{
+    if(argc != 3)
+    {
+        printf("usage: level_compiler <source.txt> <output.level>\n");
+        return 1;
+    }
+    
+    LevelSource source = {};
+    if(!level_source_parse(source, argv[1]))
+    {
+        return 1;
+    }
+    
+    std::vector<Uint8> out;
+    level_compile(source, out);
+    
+    FILE* file = fopen(argv[2], "wb");
+    if(file == NULL || fwrite(out.data(), 1, out.size(), file) != out.size())
+    {
+        printf("Unable to write %s!\n", argv[2]);
+        if(file) fclose(file);
+        return 1;
+    }
+    
+    fclose(file);
+    
+    printf("%s: %d blocks, %d colors, %u bytes\n", argv[2], (int)source.rects.size(), source.numColors, (unsigned)out.size());
+    
+    return 0;
+}
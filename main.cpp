@@ -3,11 +3,18 @@
 #include <SDL_image.h>
 #include <SDL_ttf.h>
 
-#include <string>
+#include "simulation.h"
+#include "text.h"
+#include "render.h"
+#include "pacer.h"
+#include "replay.h"
+#include "level.h"
+#include "profile.h"
+#include "histogram.h"
+#include "alloc_count.h"
+
 #include <stdio.h>
-#include <iostream>
-#include <sstream>
-#include <Fcntl.h>
+#include <fcntl.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -24,6 +31,10 @@ struct LWindow
     bool keyboardFocus;
     bool fullScreen;
     bool minimized;
+    
+    // Set by window_handle_event, cleared once the main loop has dealt with them
+    bool resized;
+    bool exposed;
 };
 
 struct LTexture
@@ -32,30 +43,6 @@ struct LTexture
     int width, height;
 };
 
-
-struct Block
-{
-    bool isActive;
-    SDL_Rect collider;
-};
-
-enum LRectangleCollision
-{
-    COLLISION_NONE = 0,
-    COLLISION_TOP = 1,
-    COLLISION_BOTTOM = 2,
-    COLLISION_LEFT = 3,
-    COLLISION_RIGHT = 4
-};
-
-struct Transform
-{
-    int posX, posY;
-    int velX, velY;
-    
-    SDL_Rect collider;
-};
-
 enum LButtonState
 {
     BUTTON_SPRITE_MOUSE_OUT = 0,
@@ -75,7 +62,26 @@ struct LButton
 const int SCREEN_WIDTH = 640;
 const int SCREEN_HEIGHT = 480;
 const int SCREEN_FPS = 60;
-const int SCREEN_TICKS_PER_FRAME = 1000 / SCREEN_FPS;
+const SDL_Color TEXT_COLOR = {0, 0, 0, 255};
+const int IDLE_WAIT_TIMEOUT = 250; // ms
+
+// Profiler overlay, one bar per frame stacked by scope
+const int PROFILE_OVERLAY_BAR_WIDTH = 2;
+const int PROFILE_OVERLAY_PIXELS_PER_MS = 6;
+
+// Every session is recorded here unless --record says otherwise
+const char* REPLAY_DEFAULT_PATH = "last.replay";
+
+// After a long stall, drop the time we couldn't simulate rather than spiraling trying to catch up
+const int SIM_MAX_TICKS_PER_FRAME = 8;
+
+// Starting sizes, either one grows to fit at its next reset if it has to
+const size_t LEVEL_ARENA_SIZE = 64 * 1024;
+const size_t FRAME_ARENA_SIZE = 16 * 1024;
+
+// Frames after startup (or waking from idle) that can still be filling caches, batches and the
+// like. Any heap allocation after that in a frame is counted as a steady state one.
+const int ALLOCATION_WARMUP_FRAMES = 60;
 
 LWindow gWindow;
 
@@ -83,11 +89,13 @@ SDL_Surface* gScreenSurface = NULL;
 SDL_Renderer* gRenderer = NULL;
 TTF_Font *gFont = NULL;
 
-LTexture gTextTexture;
+GlyphAtlas gGlyphAtlas;
+
+FrameStats gFrameStats;
 
-const int MOVE_VEL = 10;
-const int BALL_VEL = 3;
-const int BALL_MAX_VEL = 8;
+// Blocks and the grid, reset on every level change. Scratch for a single frame, reset at the start of each.
+Arena gLevelArena;
+Arena gFrameArena;
 
 const int BUTTON_WIDTH = 300;
 const int BUTTON_HEIGHT = 200;
@@ -97,14 +105,14 @@ SDL_Rect gSpriteClips[TOTAL_BUTTONS];
 LTexture gButtonSpriteSheetTexture;
 LButton gButtons[TOTAL_BUTTONS];
 
-SDL_Surface* create_surface_from_file(std::string path)
+SDL_Surface* create_surface_from_file(const char* path)
 {
     SDL_Surface* optimizedSurface = NULL;
     
-    SDL_Surface* loadedSurface = IMG_Load(path.c_str());
+    SDL_Surface* loadedSurface = IMG_Load(path);
     if(loadedSurface == NULL)
     {
-        printf("Unable to load image %s! SDL Error: %s\n", path.c_str(), IMG_GetError());
+        printf("Unable to load image %s! SDL Error: %s\n", path, IMG_GetError());
     }
     else
     {
@@ -113,7 +121,7 @@ SDL_Surface* create_surface_from_file(std::string path)
         optimizedSurface = SDL_ConvertSurface(loadedSurface, gScreenSurface->format, NULL);
         if(optimizedSurface == NULL)
         {
-            printf("Unable to load optimized surface %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+            printf("Unable to load optimized surface %s! SDL Error: %s\n", path, SDL_GetError());
         }
         
         SDL_FreeSurface(loadedSurface);
@@ -122,21 +130,21 @@ SDL_Surface* create_surface_from_file(std::string path)
     return optimizedSurface;
 }
 
-SDL_Texture* create_texture_from_file(std::string path, int& width, int& height)
+SDL_Texture* create_texture_from_file(const char* path, int& width, int& height)
 {
     SDL_Texture* newTexture = NULL;
     
-    SDL_Surface* loadedSurface = IMG_Load(path.c_str());
+    SDL_Surface* loadedSurface = IMG_Load(path);
     if(loadedSurface == NULL)
     {
-        printf("Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
+        printf("Unable to load image %s! SDL_image Error: %s\n", path, IMG_GetError());
     }
     else
     {
         newTexture = SDL_CreateTextureFromSurface(gRenderer, loadedSurface);
         if(newTexture == NULL)
         {
-            printf("Unable to create texture from %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
+            printf("Unable to create texture from %s! SDL_image Error: %s\n", path, IMG_GetError());
         }
         else
         {
@@ -151,11 +159,11 @@ SDL_Texture* create_texture_from_file(std::string path, int& width, int& height)
 }
 
 #ifdef _SDL_TTF_H
-SDL_Texture* create_texture_from_text(std::string textureText, int& width, int& height, SDL_Color textColor)
+SDL_Texture* create_texture_from_text(const char* textureText, int& width, int& height, SDL_Color textColor)
 {
     SDL_Texture* result = NULL;
     
-    SDL_Surface* textSurface = TTF_RenderText_Solid(gFont, textureText.c_str(), textColor);
+    SDL_Surface* textSurface = TTF_RenderText_Solid(gFont, textureText, textColor);
     if(textSurface == NULL)
     {
         printf("Unable to render text surface! SDL_ttf Error: %s\n", TTF_GetError());
@@ -193,98 +201,6 @@ void render_texture_at_pos(LTexture& texture, int x, int y, SDL_Rect* clip = NUL
     SDL_RenderCopyEx(gRenderer, texture.texture, clip, &renderQuad, angle, center, flip);
 }
 
-int clamp(int current, int min, int max)
-{
-    if(current > max) return max;
-    if(current < min) return min;
-    
-    return current;
-}
-
-// NOTE(chris) source: https://gamedev.stackexchange.com/questions/29786/a-simple-2d-rectangle-collision-algorithm-that-also-determines-which-sides-that/29796#29796
-LRectangleCollision check_collision(SDL_Rect a, SDL_Rect b)
-{
-    int width = (a.w + b.w) / 2;
-    int height = (a.h + b.h) / 2;
-    
-    int aCenterX = a.x + (a.w / 2);
-    int aCenterY = a.y + (a.h / 2);
-    
-    int bCenterX = b.x + (b.w / 2);
-    int bCenterY = b.y + (b.h / 2);
-    
-    int deltaX = aCenterX - bCenterX;
-    int deltaY = aCenterY - bCenterY;
-    
-    if(abs(deltaX) <= width && abs(deltaY) <= height)
-    {
-        // A collision has occurred, solve for which side
-        int crossWidth = width * deltaY;
-        int crossHeight = height * deltaX;
-        
-        if(crossWidth > crossHeight)
-        {
-            if(crossWidth > -crossHeight)
-            {
-                return COLLISION_TOP;
-            }
-            else
-            {
-                return COLLISION_LEFT;
-            }
-        }
-        else
-        {
-            if(crossWidth > -crossHeight)
-            {
-                return COLLISION_RIGHT;
-            }
-            else
-            {
-                return COLLISION_BOTTOM;
-            }
-        }
-        
-        return COLLISION_TOP;
-    }
-    
-    return COLLISION_NONE;
-}
-
-bool check_window_collision_x(Transform transform)
-{
-    return (transform.posX < 0 || transform.posX + transform.collider.w > gWindow.width);
-} 
-
-bool check_window_collision_y(Transform transform)
-{
-    return (transform.posY < 0 || transform.posY + transform.collider.h > gWindow.height);
-}
-
-void transform_move(Transform& transform)
-{
-    transform.posX += transform.velX;
-    transform.collider.x = transform.posX;
-    
-    transform.posY += transform.velY;
-    transform.collider.y = transform.posY;
-}
-
-void transform_keep_on_screen(Transform& transform)
-{
-    if(check_window_collision_x(transform))
-    {
-        transform.posX -= transform.velX;
-        transform.collider.x = transform.posX;
-    }
-    
-    if(check_window_collision_y(transform))
-    {
-        transform.posY -= transform.velY;
-        transform.collider.y = transform.posY;
-    }
-}
-
 void button_set_positions(LButton& button, int x, int y)
 {
     button.position.x = x;
@@ -341,6 +257,35 @@ void button_handle_event(LButton& button, SDL_Event* e)
     }
 }
 
+// --dirty-rects draws with the software renderer straight into the window surface. Resizing the window
+// replaces that surface, so the renderer and the glyph atlas texture it owns are made again.
+bool software_renderer_create(LWindow& window)
+{
+    glyph_atlas_destroy(gGlyphAtlas);
+    SDL_DestroyRenderer(gRenderer);
+    
+    gScreenSurface = SDL_GetWindowSurface(window.window);
+    gRenderer = gScreenSurface ? SDL_CreateSoftwareRenderer(gScreenSurface) : NULL;
+    if(gRenderer == NULL)
+    {
+        printf("Software renderer could not be created! SDL Error: %s\n", SDL_GetError());
+        return false;
+    }
+    
+    if(gFont && !glyph_atlas_create(gGlyphAtlas, gRenderer, gFont, TEXT_COLOR))
+    {
+        printf("Failed to create glyph atlas!\n");
+    }
+    
+    return true;
+}
+
+// Minimized or in the background, there's nothing worth updating or drawing
+bool window_is_idle(LWindow& window)
+{
+    return window.minimized || !window.keyboardFocus;
+}
+
 void window_handle_event(LWindow& window, SDL_Event& e)
 {
     if(e.type == SDL_WINDOWEVENT)
@@ -352,10 +297,12 @@ void window_handle_event(LWindow& window, SDL_Event& e)
             case SDL_WINDOWEVENT_SIZE_CHANGED:
             window.width = e.window.data1;
             window.height = e.window.data2;
+            window.resized = true;
             SDL_RenderPresent(gRenderer);
             break;
             
             case SDL_WINDOWEVENT_EXPOSED: // The window was obscured in some way and is now no longer obscured
+            window.exposed = true;
             SDL_RenderPresent(gRenderer);
             break;
             
@@ -394,9 +341,10 @@ void window_handle_event(LWindow& window, SDL_Event& e)
         
         if(updateCaption)
         {
-            std::stringstream caption;
-            caption << "Breakout - MouseFocus: " << ((window.mouseFocus) ? "On" : "Off") << " KeyboardFocus: " << ((window.keyboardFocus) ? "On" : "Off");
-            SDL_SetWindowTitle(window.window, caption.str().c_str());
+            char caption[64];
+            SDL_snprintf(caption, sizeof(caption), "Breakout - MouseFocus: %s KeyboardFocus: %s",
+                         window.mouseFocus ? "On" : "Off", window.keyboardFocus ? "On" : "Off");
+            SDL_SetWindowTitle(window.window, caption);
         }
     }
     else if(e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_RETURN)
@@ -415,65 +363,210 @@ void window_handle_event(LWindow& window, SDL_Event& e)
     }
 }
 
-Block* block_row_create(int& numBlocks, int yPos, int width, int height, int spacing)
+#ifdef BREAKOUT_PROFILE
+void profile_overlay_render(SDL_Renderer* renderer, GlyphAtlas& atlas, RenderBatch& batch, int x, int bottom)
 {
-    numBlocks = gWindow.width / width;
+    static const SDL_Color scopeColors[PROFILE_SCOPE_COUNT] =
+    {
+        {0xE0, 0x40, 0x40, 0xFF}, // events
+        {0xE0, 0xA0, 0x20, 0xFF}, // paddle
+        {0x40, 0xA0, 0x40, 0xFF}, // balls
+        {0x40, 0x80, 0xE0, 0xFF}, // text
+        {0x80, 0x40, 0xC0, 0xFF}, // render
+        {0xC0, 0x40, 0x90, 0xFF}, // present
+        {0xC8, 0xC8, 0xC8, 0xFF}, // sleep
+    };
+    SDL_Color otherColor = {0x60, 0x60, 0x60, 0xFF};
+    SDL_Color budgetColor = {0x00, 0x00, 0x00, 0xFF};
+    
+    render_batch_begin(batch);
+    
+    Uint64 scopeTotals[PROFILE_SCOPE_COUNT] = {};
+    
+    for(int age = 0; age < gProfiler.numFrames; ++age)
+    {
+        ProfileFrame& frame = profile_frame(age);
+        
+        SDL_Rect bar;
+        bar.x = x + age * PROFILE_OVERLAY_BAR_WIDTH;
+        bar.w = PROFILE_OVERLAY_BAR_WIDTH;
+        bar.y = bottom;
+        
+        Uint64 accounted = 0;
+        for(int scope = 0; scope < PROFILE_SCOPE_COUNT; ++scope)
+        {
+            bar.h = (int)(profile_ms(frame.scopes[scope]) * PROFILE_OVERLAY_PIXELS_PER_MS + 0.5);
+            bar.y -= bar.h;
+            if(bar.h > 0) render_batch_add_rect(batch, scopeColors[scope], bar);
+            
+            accounted += frame.scopes[scope];
+            scopeTotals[scope] += frame.scopes[scope];
+        }
+        
+        // Whatever no scope covered
+        if(frame.total > accounted)
+        {
+            bar.h = (int)(profile_ms(frame.total - accounted) * PROFILE_OVERLAY_PIXELS_PER_MS + 0.5);
+            bar.y -= bar.h;
+            if(bar.h > 0) render_batch_add_rect(batch, otherColor, bar);
+        }
+    }
     
-    Block* blocks = new Block[numBlocks];
+    render_batch_submit(renderer, batch);
     
-    for(int i = 0; i < numBlocks; ++i)
+    // Where a 60 FPS frame runs out
+    SDL_Rect budget;
+    budget.x = x;
+    budget.y = bottom - (int)(1000.0 / SCREEN_FPS * PROFILE_OVERLAY_PIXELS_PER_MS);
+    budget.w = PROFILE_MAX_FRAMES * PROFILE_OVERLAY_BAR_WIDTH;
+    budget.h = 1;
+    render_fill_rect(renderer, budgetColor, &budget);
+    
+    // Legend with the average of each scope over the frames shown, drawn above the graph
+    int lineY = budget.y - (PROFILE_SCOPE_COUNT + 1) * atlas.lineHeight;
+    int numFrames = gProfiler.numFrames > 0 ? gProfiler.numFrames : 1;
+    
+    for(int scope = 0; scope < PROFILE_SCOPE_COUNT; ++scope)
     {
-        blocks[i].collider.x = (i * width) + (i * spacing);
-        blocks[i].collider.y = yPos;
+        SDL_Rect swatch = {x, lineY + atlas.lineHeight / 4, atlas.lineHeight / 2, atlas.lineHeight / 2};
+        render_fill_rect(renderer, scopeColors[scope], &swatch);
         
-        blocks[i].collider.w = width;
-        blocks[i].collider.h = height;
+        char* line = arena_printf(gFrameArena, "%s %.2f ms", gProfileScopeNames[scope], profile_ms(scopeTotals[scope]) / numFrames);
+        text_render(renderer, atlas, line, x + atlas.lineHeight, lineY);
         
-        blocks[i].isActive = true;
-    } 
-    
-    return blocks;
+        lineY += atlas.lineHeight;
+    }
 }
+#endif
 
-void block_row_collisions(Transform& ball, Block* blocks, int numBlocks)
+// Steps a recorded session as fast as possible with no window, then checks it ended up where the
+// recording did. Returns the process exit code: 0 if it did, 2 if it didn't, 1 if the replay or level
+// couldn't be loaded or the replay is corrupt and 3 if the replay was recorded on a different level
+// than it would be run on.
+int replay_run(const char* path, const char* levelPath)
 {
-    for(int i = 0; i < numBlocks; ++i)
+    ReplayPlayer player;
+    if(!replay_player_load(player, path))
+    {
+        return 1;
+    }
+    
+    LevelFile level = {};
+    if(levelPath && !level_file_map(level, levelPath))
+    {
+        return 1;
+    }
+    
+    // Running on the wrong level can only end in a hash mismatch that looks like lost determinism
+    Uint32 levelId = levelPath ? level_header(level).id : 0;
+    if(levelId != player.header.level)
     {
-        if(blocks[i].isActive)
+        if(!levelPath)
         {
-            LRectangleCollision result = check_collision(ball.collider, blocks[i].collider);
-            if(result != COLLISION_NONE)
-            {
-                if(result == COLLISION_LEFT || result == COLLISION_RIGHT)
-                {
-                    ball.velX = -ball.velX;
-                }
-                else if (result == COLLISION_TOP || result == COLLISION_BOTTOM)
-                {
-                    ball.velY = -ball.velY;
-                }
-                
-                blocks[i].isActive = false;
-                break;
-            }
+            printf("%s was recorded on level %u, pass that level with --level\n", path, player.header.level);
+        }
+        else if(player.header.level == 0)
+        {
+            printf("%s was recorded on the built in level, not %s (level %u)\n", path, levelPath, levelId);
         }
+        else
+        {
+            printf("%s was recorded on level %u, %s is level %u\n", path, player.header.level, levelPath, levelId);
+        }
+        
+        level_file_unmap(level);
+        return 3;
     }
-}
-
-void block_row_render(Block* blocks, int numBlocks)
-{
-    for(int i = 0; i < numBlocks; ++i)
+    
+    World world;
+    if(levelPath)
     {
-        if(blocks[i].isActive)
+        if(!world_create_from_level(world, level))
         {
-            SDL_RenderFillRect(gRenderer, &blocks[i].collider);
+            level_file_unmap(level);
+            return 1;
         }
     }
+    else
+    {
+        world_create(world, player.header.width, player.header.height);
+    }
+    
+    WorldInput input = {};
+    
+    Uint64 start = SDL_GetPerformanceCounter();
+    
+    while(replay_player_tick(player, world, input))
+    {
+        world_step(world, input);
+    }
+    
+    double seconds = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+    
+    if(player.tick != player.header.numTicks)
+    {
+        printf("%s is corrupt, its inputs stop at tick %llu of %llu\n", path, (unsigned long long)player.tick,
+               (unsigned long long)player.header.numTicks);
+        world_destroy(world);
+        level_file_unmap(level);
+        return 1;
+    }
+    
+    Uint64 hash = world_hash(world);
+    bool match = hash == player.header.finalHash;
+    
+    printf("%s: %llu ticks in %.3f s, %.0f ticks/s\n", path, (unsigned long long)world.tick, seconds, world.tick / seconds);
+    printf("final hash %016llx, recorded %016llx: %s\n", (unsigned long long)hash, (unsigned long long)player.header.finalHash,
+           match ? "match" : "MISMATCH");
+    
+    // The world borrows the level's blocks, so the level goes after it
+    world_destroy(world);
+    level_file_unmap(level);
+    
+    return match ? 0 : 2;
 }
 
 #undef main // HACK(chris) SDL seems to define its own main function, so we need to undefine it (https://stackoverflow.com/a/30189915)
 int main (int argc, char *argv[])
 {
+    // Before SDL_Init, so everything SDL allocates is freed by the functions that allocated it
+    heap_track_sdl_allocations();
+    
+    const char* recordPath = REPLAY_DEFAULT_PATH;
+    const char* tracePath = NULL;
+    const char* replayPath = NULL;
+    const char* levelPath = NULL;
+    bool dirtyRects = false;
+    
+    for(int i = 1; i < argc; ++i)
+    {
+        if(SDL_strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            replayPath = argv[++i];
+        }
+        else if(SDL_strcmp(argv[i], "--level") == 0 && i + 1 < argc)
+        {
+            levelPath = argv[++i];
+        }
+        else if(SDL_strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+        {
+            recordPath = argv[++i];
+        }
+        else if(SDL_strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+        {
+            tracePath = argv[++i];
+        }
+        else if(SDL_strcmp(argv[i], "--dirty-rects") == 0)
+        {
+            dirtyRects = true;
+        }
+    }
+    
+    if(replayPath)
+    {
+        return replay_run(replayPath, levelPath);
+    }
+    
     { // Init
         bool success = true;
     
@@ -496,7 +589,21 @@ int main (int argc, char *argv[])
             }
             else
             {
-                gRenderer = SDL_CreateRenderer(gWindow.window, -1, SDL_RENDERER_ACCELERATED);
+                // Focus events only arrive on change, so start from the window's current state
+                Uint32 windowFlags = SDL_GetWindowFlags(gWindow.window);
+                gWindow.mouseFocus = (windowFlags & SDL_WINDOW_MOUSE_FOCUS) != 0;
+                gWindow.keyboardFocus = (windowFlags & SDL_WINDOW_INPUT_FOCUS) != 0;
+                gWindow.minimized = (windowFlags & SDL_WINDOW_MINIMIZED) != 0;
+                
+                if(dirtyRects)
+                {
+                    software_renderer_create(gWindow);
+                }
+                else
+                {
+                    gRenderer = SDL_CreateRenderer(gWindow.window, -1, SDL_RENDERER_ACCELERATED);
+                }
+                
                 if(gRenderer == NULL)
                 {
                     printf("Renderer could not be created! SDL Error: %s\n", SDL_GetError());
@@ -530,11 +637,13 @@ int main (int argc, char *argv[])
         {
             printf("Failed to load lazy font! SDL_ttf Error: %s\n", TTF_GetError());
         }
-        // else
-        // {
-        //     SDL_Color textColor = {0, 0, 0};
-        //     gTextTexture.texture = create_texture_from_text("", gTextTexture.width, gTextTexture.height, textColor);
-        // }
+        else
+        {
+            if(!glyph_atlas_create(gGlyphAtlas, gRenderer, gFont, TEXT_COLOR))
+            {
+                printf("Failed to create glyph atlas!\n");
+            }
+        }
         
         // gButtonSpriteSheetTexture.texture = create_texture_from_file("button.png", gButtonSpriteSheetTexture.width, gButtonSpriteSheetTexture.height);
         
@@ -556,177 +665,332 @@ int main (int argc, char *argv[])
     bool quit = false;
     SDL_Event e;
     
-    SDL_Color textColor = {0, 0, 0, 255};
-    std::stringstream timeText;
+    int lastFrameDrawCalls = 0;
+    
+    arena_create(gLevelArena, LEVEL_ARENA_SIZE);
+    arena_create(gFrameArena, FRAME_ARENA_SIZE);
     
-    int countedFrames = 0;
-    Uint32 appTimer = SDL_GetTicks();
-    Uint32 frameTimer;
+    Uint64 lastFrameAllocations = 0;
+    int warmupFrames = ALLOCATION_WARMUP_FRAMES;
+    Uint64 steadyFrames = 0;
+    Uint64 steadyFramesAllocating = 0;
+    
+    WorldRenderer worldRenderer = {};
+    
+    // Present to present, 0 until the first frame after startup or waking from idle
+    Uint64 lastPresentTime = 0;
+    
+    FramePacer pacer;
+    frame_pacer_init(pacer, SCREEN_FPS);
     
     // Game
-    Transform paddle;
-    
-    paddle.collider.w = 100;
-    paddle.collider.h = 40;
-    paddle.posX = gWindow.width / 2;
-    paddle.posY = gWindow.height - 30;
-    
-    Transform ball;
-    ball.collider.w = 25;
-    ball.collider.h = 25;
-    ball.posX = gWindow.width / 4;
-    ball.posY = gWindow.height / 2;
-    ball.velX = BALL_VEL;
-    ball.velY = -BALL_VEL;
-    
-    int blockRow1Count, blockRow2Count, blockRow3Count;
-    Block* blockRow1;
-    Block* blockRow2;
-    Block* blockRow3;
-    
-    int yPos = 0;
-    blockRow1 = block_row_create(blockRow1Count, yPos, 200, 20, 3);
-    yPos += 20;
-    blockRow2 = block_row_create(blockRow2Count, yPos, 100, 40, 3);
-    yPos += 40;
-    blockRow3 = block_row_create(blockRow3Count, yPos, 50, 20, 3);
+    LevelFile level = {};
+    World world;
+    arena_reset(gLevelArena);
+    if(levelPath && level_file_map(level, levelPath) && world_create_from_level(world, level, &gLevelArena))
+    {
+        printf("Playing %s\n", levelPath);
+    }
+    else
+    {
+        if(levelPath)
+        {
+            printf("Falling back to the built in level\n");
+            level_file_unmap(level);
+        }
+        
+        arena_reset(gLevelArena);
+        world_create(world, gWindow.width, gWindow.height, &gLevelArena);
+    }
+    
+    WorldInput input = {};
+    
+    ReplayRecorder recorder;
+    replay_recorder_begin(recorder, world);
+    recorder.header.level = level.data ? level_header(level).id : 0;
+    
+    // Fixed timestep, real elapsed time is banked in the accumulator and spent in whole ticks
+    Uint64 tickCounts = SDL_GetPerformanceFrequency() / WORLD_TICKS_PER_SECOND;
+    Uint64 simAccumulator = 0;
+    Uint64 simLastTime = SDL_GetPerformanceCounter();
+    
+    Transform previousPaddle = world.paddle;
+    
+    if(tracePath)
+    {
+#ifdef BREAKOUT_PROFILE
+        trace_begin(tracePath);
+#else
+        printf("--trace needs a build with BREAKOUT_PROFILE defined, not tracing\n");
+#endif
+    }
+    
+    bool showProfiler = false;
+    
+    // Dirty rect mode only, everything is redrawn when this is set
+    bool redrawAll = true;
+    DirtyRects dirty = {};
+    SDL_Rect hudRect = {};
+    RenderBatch profileBatch = {};
     
     while(!quit)
     {
-        frameTimer = SDL_GetTicks();
+        PROFILE_FRAME();
+        
+        arena_reset(gFrameArena);
+        Uint64 frameStartAllocations = heap_allocation_count();
         
-        while(SDL_PollEvent(&e) != 0)
+        if(window_is_idle(gWindow))
         {
-            if(e.type == SDL_QUIT)
-            {
-                quit = true;
-            }
-            else if(e.type == SDL_KEYDOWN)
+            PROFILE_SCOPE(PROFILE_SLEEP);
+            
+            // Sleep until something happens rather than spinning on SDL_PollEvent. Passing NULL leaves
+            // the event in the queue for the poll loop below.
+            SDL_WaitEventTimeout(NULL, IDLE_WAIT_TIMEOUT);
+            
+            // The game is paused while idle, don't bank the time for the simulation to catch up on
+            simLastTime = SDL_GetPerformanceCounter();
+            
+            // Nor count the pause as one long frame
+            lastPresentTime = 0;
+            warmupFrames = ALLOCATION_WARMUP_FRAMES;
+            
+            // Whatever covered the window may not have sent an expose
+            redrawAll = true;
+        }
+        
+        {
+            PROFILE_SCOPE(PROFILE_EVENTS);
+            
+            while(SDL_PollEvent(&e) != 0)
             {
-                switch(e.key.keysym.sym)
+                if(e.type == SDL_QUIT)
                 {
-                    case SDLK_ESCAPE:
                     quit = true;
-                    break;
+                }
+                else if(e.type == SDL_RENDER_TARGETS_RESET)
+                {
+                    // Direct3D can lose what was drawn into target textures
+                    world_renderer_invalidate(worldRenderer);
+                }
+                else if(e.type == SDL_RENDER_DEVICE_RESET)
+                {
+                    // Or the textures themselves, the layer is made again next frame and the glyph
+                    // atlas right away, the same way a new software renderer gets one
+                    world_renderer_destroy(worldRenderer);
                     
-                    default:
-                    break;
+                    glyph_atlas_destroy(gGlyphAtlas);
+                    if(gFont && !glyph_atlas_create(gGlyphAtlas, gRenderer, gFont, TEXT_COLOR))
+                    {
+                        printf("Failed to create glyph atlas!\n");
+                    }
                 }
-            }
-            
-            window_handle_event(gWindow, e);
-            
-            for(int i = 0; i < TOTAL_BUTTONS; ++i)
-            {
-                button_handle_event(gButtons[i], &e);
-            }
-            
-            paddle.velX = 0;
-            paddle.velY = 0;
-            if(e.type == SDL_KEYDOWN)
-            {
-                switch(e.key.keysym.sym)
+                else if(e.type == SDL_KEYDOWN)
                 {
-                    // case SDLK_UP: paddle.velY = -MOVE_VEL; break;
-                    // case SDLK_DOWN: paddle.velY = MOVE_VEL; break;
-                    case SDLK_LEFT: paddle.velX = -MOVE_VEL; break;
-                    case SDLK_RIGHT: paddle.velX = MOVE_VEL; break;
+                    switch(e.key.keysym.sym)
+                    {
+                        case SDLK_ESCAPE:
+                        quit = true;
+                        break;
+                        
+                        case SDLK_F1:
+                        showProfiler = !showProfiler;
+                        redrawAll = true;
+                        break;
+                        
+                        default:
+                        break;
+                    }
                 }
+                
+                window_handle_event(gWindow, e);
+                
+                for(int i = 0; i < TOTAL_BUTTONS; ++i)
+                {
+                    button_handle_event(gButtons[i], &e);
+                }
+                
+                input.paddleVelX = 0;
+                if(e.type == SDL_KEYDOWN)
+                {
+                    switch(e.key.keysym.sym)
+                    {
+                        case SDLK_LEFT: input.paddleVelX = -MOVE_VEL; break;
+                        case SDLK_RIGHT: input.paddleVelX = MOVE_VEL; break;
+                    }
+                }
+            }
+        }
+        
+        if(gWindow.resized && dirtyRects)
+        {
+            // The block layer belongs to the renderer that's about to go
+            world_renderer_destroy(worldRenderer);
+            if(!software_renderer_create(gWindow))
+            {
+                quit = true;
+                break;
             }
         }
         
-        if(!gWindow.minimized)
+        if(gWindow.resized || gWindow.exposed)
+        {
+            gWindow.resized = false;
+            gWindow.exposed = false;
+            redrawAll = true;
+        }
+        
+        if(!window_is_idle(gWindow))
         {
-            transform_move(paddle);
-            transform_keep_on_screen(paddle);
+            world.width = gWindow.width;
+            world.height = gWindow.height;
             
-            transform_move(ball);
-            if(check_window_collision_x(ball))
+            Uint64 simNow = SDL_GetPerformanceCounter();
+            simAccumulator += simNow - simLastTime;
+            simLastTime = simNow;
+            
+            if(simAccumulator > tickCounts * SIM_MAX_TICKS_PER_FRAME)
             {
-                ball.velX = -ball.velX;
+                simAccumulator = tickCounts * SIM_MAX_TICKS_PER_FRAME;
             }
             
-            if(ball.posY < 0)
+            while(simAccumulator >= tickCounts)
             {
-                ball.velY = -ball.velY;
+                previousPaddle = world.paddle;
+                
+                replay_recorder_tick(recorder, world, input);
+                world_step(world, input);
+                simAccumulator -= tickCounts;
             }
             
-            // TODO(chris) if(ball.posY + ball.collider.h > gWindow.height)
-            block_row_collisions(ball, blockRow1, blockRow1Count);
-            block_row_collisions(ball, blockRow2, blockRow2Count);
-            block_row_collisions(ball, blockRow3, blockRow3Count);
+            // Draw where things are between the last two ticks, so motion stays smooth at any render rate
+            float alpha = (float)simAccumulator / (float)tickCounts;
+            SDL_Rect paddleCollider = transform_interpolate(previousPaddle, world.paddle, alpha);
             
-            if(check_collision(paddle.collider, ball.collider))
+            char* frameTimeText;
+            char* drawCallsText;
+            char* allocationsText;
             {
-                // Add velocity based on which side of the paddle we hit
-                if(paddle.collider.x + paddle.collider.w / 2 > ball.collider.x + ball.collider.w / 2)
+                PROFILE_SCOPE(PROFILE_TEXT);
+                
+                Histogram& window = gFrameStats.window;
+                frameTimeText = arena_printf(gFrameArena, "Frame ms p50 %.1f p95 %.1f p99 %.1f max %.1f",
+                                             histogram_percentile(window, 50) / 1000.0, histogram_percentile(window, 95) / 1000.0,
+                                             histogram_percentile(window, 99) / 1000.0, histogram_percentile(window, 100) / 1000.0);
+                drawCallsText = arena_printf(gFrameArena, "Draw calls: %d", lastFrameDrawCalls);
+                allocationsText = arena_printf(gFrameArena, "Heap allocations: %llu last frame, %llu of %llu steady frames",
+                                               (unsigned long long)lastFrameAllocations, (unsigned long long)steadyFramesAllocating,
+                                               (unsigned long long)steadyFrames);
+            }
+            
+            {
+                PROFILE_SCOPE(PROFILE_RENDER);
+                
+                render_stats_reset();
+                
+                // render_texture_at_pos(gButtonSpriteSheetTexture, gButtons[3].position.x, gButtons[3].position.y, &gSpriteClips[gButtons[3].currentState]);
+                
+                if(dirtyRects)
                 {
-                    ball.velX = -abs(ball.velX + paddle.velX);
+                    dirty_rects_reset(dirty);
+                    dirty.full = redrawAll || showProfiler;
+                    redrawAll = false;
+                    
+                    // The HUD changes every frame, clear where it was and make room for where it's going
+                    SDL_Rect hud = {0, 0, 0, gGlyphAtlas.lineHeight * 3};
+                    hud.w = SDL_max(text_width(gGlyphAtlas, frameTimeText), text_width(gGlyphAtlas, drawCallsText));
+                    hud.w = SDL_max(hud.w, text_width(gGlyphAtlas, allocationsText));
+                    dirty_rects_add(dirty, hudRect);
+                    dirty_rects_add(dirty, hud);
+                    hudRect = hud;
+                    
+                    world_render_dirty(gRenderer, worldRenderer, world, paddleCollider, alpha, dirty);
                 }
                 else
                 {
-                    ball.velX = abs(ball.velX + paddle.velX);
+                    world_render(gRenderer, worldRenderer, world, paddleCollider, alpha);
                 }
-                
-                ball.velY = -ball.velY - 1; // add a little bit of vertical vel each paddle collision
             }
             
-            ball.velX = clamp(ball.velX, -BALL_MAX_VEL, BALL_MAX_VEL);
-            ball.velY = clamp(ball.velY, -BALL_MAX_VEL, BALL_MAX_VEL);
-            
-            float averageFPS = countedFrames / ((SDL_GetTicks() - appTimer) / 1000.0f);
-            
-            if(averageFPS > 2000000) averageFPS = 0;
-            
-            timeText.str("");
-            timeText << "FPS: " << averageFPS;
-            
-            gTextTexture.texture = create_texture_from_text(timeText.str().c_str(), gTextTexture.width, gTextTexture.height, textColor);
-            
-            SDL_RenderClear(gRenderer); 
-            
-            // render_texture_at_pos(gButtonSpriteSheetTexture, gButtons[3].position.x, gButtons[3].position.y, &gSpriteClips[gButtons[3].currentState]);
-            
-            SDL_SetRenderDrawColor(gRenderer, 0xFF, 0x00, 0x00, 0xFF);
-            block_row_render(blockRow1, blockRow1Count);
-            
-            SDL_SetRenderDrawColor(gRenderer, 0x00, 0xFF, 0x00, 0xFF);
-            block_row_render(blockRow2, blockRow2Count);
-            
-            SDL_SetRenderDrawColor(gRenderer, 0x00, 0x00, 0xFF, 0xFF);
-            block_row_render(blockRow3, blockRow3Count);
-            
-            SDL_SetRenderDrawColor(gRenderer, 0x00, 0x00, 0x00, 0xFF);
-            SDL_RenderFillRect(gRenderer, &paddle.collider);
-            
-            SDL_SetRenderDrawColor(gRenderer, 0x00, 0xFF, 0x00, 0xFF);
-            SDL_RenderFillRect(gRenderer, &ball.collider);
-            
-            
-            // Render UI last
-            SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
-            render_texture_at_pos(gTextTexture, 0, 0);
+            {
+                PROFILE_SCOPE(PROFILE_TEXT);
+                
+                // Render UI last
+                text_render(gRenderer, gGlyphAtlas, frameTimeText, 0, 0);
+                text_render(gRenderer, gGlyphAtlas, drawCallsText, 0, gGlyphAtlas.lineHeight);
+                text_render(gRenderer, gGlyphAtlas, allocationsText, 0, gGlyphAtlas.lineHeight * 2);
+                
+#ifdef BREAKOUT_PROFILE
+                if(showProfiler)
+                {
+                    int graphX = gWindow.width - PROFILE_MAX_FRAMES * PROFILE_OVERLAY_BAR_WIDTH;
+                    profile_overlay_render(gRenderer, gGlyphAtlas, profileBatch, graphX, gWindow.height);
+                }
+#endif
+                
+                lastFrameDrawCalls = gRenderStats.drawCalls;
+            }
             
+            {
+                PROFILE_SCOPE(PROFILE_PRESENT);
+                
+                if(!dirtyRects)
+                {
+                    SDL_RenderPresent(gRenderer);
+                }
+                else if(dirty.full)
+                {
+                    SDL_UpdateWindowSurface(gWindow.window);
+                }
+                else if(dirty.numRects > 0)
+                {
+                    SDL_UpdateWindowSurfaceRects(gWindow.window, dirty.rects, dirty.numRects);
+                }
+                
+                Uint64 presentTime = SDL_GetPerformanceCounter();
+                if(lastPresentTime)
+                {
+                    Uint64 frameMicros = (presentTime - lastPresentTime) * 1000000 / SDL_GetPerformanceFrequency();
+                    frame_stats_add(gFrameStats, (Uint32)SDL_min(frameMicros, (Uint64)HISTOGRAM_MAX_VALUE));
+                }
+                lastPresentTime = presentTime;
+            }
             
-            SDL_RenderPresent(gRenderer);
-            ++countedFrames;
+            {
+                PROFILE_SCOPE(PROFILE_SLEEP);
+                
+                // Wait until we reach 60 FPS (in case the frame completes early)
+                frame_pacer_wait(pacer);
+            }
             
-            // Wait until we reach 60 FPS (in case the frame completes early)
-            int frameTicks = SDL_GetTicks() - frameTimer;
-            if(frameTicks < SCREEN_TICKS_PER_FRAME)
+            lastFrameAllocations = heap_allocation_count() - frameStartAllocations;
+            if(warmupFrames > 0)
             {
-                SDL_Delay(SCREEN_TICKS_PER_FRAME - frameTicks);
+                --warmupFrames;
+            }
+            else
+            {
+                ++steadyFrames;
+                if(lastFrameAllocations) ++steadyFramesAllocating;
             }
         }
     }
 
     { // close
         
-        delete[] blockRow1;
-        delete[] blockRow2;
-        delete[] blockRow3;
-    
-        SDL_DestroyTexture(gTextTexture.texture);
+        trace_end();
+        frame_stats_dump(gFrameStats);
+        printf("Heap allocations: %llu of %llu steady state frames allocated\n",
+               (unsigned long long)steadyFramesAllocating, (unsigned long long)steadyFrames);
+        
+        replay_recorder_save(recorder, world, recordPath);
+        world_destroy(world);
+        level_file_unmap(level);
+        arena_destroy(gLevelArena);
+        arena_destroy(gFrameArena);
+    
+        world_renderer_destroy(worldRenderer);
+        glyph_atlas_destroy(gGlyphAtlas);
         SDL_DestroyTexture(gButtonSpriteSheetTexture.texture);
     
         TTF_CloseFont(gFont);
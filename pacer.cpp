@@ -0,0 +1,66 @@
+#include "pacer.h"
+
+void frame_pacer_init(FramePacer& pacer, int framesPerSecond)
+{
+    pacer.frequency = SDL_GetPerformanceFrequency();
+    pacer.framesPerSecond = framesPerSecond;
+    
+    pacer.period = pacer.frequency / framesPerSecond;
+    pacer.periodRemainder = pacer.frequency % framesPerSecond;
+    
+    pacer.spinMargin = pacer.frequency * PACER_SPIN_MARGIN_US / 1000000;
+    
+    frame_pacer_reset(pacer);
+}
+
+static void frame_pacer_advance(FramePacer& pacer)
+{
+    pacer.nextDeadline += pacer.period;
+    
+    pacer.remainderAccumulator += pacer.periodRemainder;
+    if(pacer.remainderAccumulator >= (Uint64)pacer.framesPerSecond)
+    {
+        pacer.remainderAccumulator -= pacer.framesPerSecond;
+        ++pacer.nextDeadline;
+    }
+}
+
+void frame_pacer_reset(FramePacer& pacer)
+{
+    pacer.nextDeadline = SDL_GetPerformanceCounter();
+    pacer.remainderAccumulator = 0;
+    
+    frame_pacer_advance(pacer);
+}
+
+void frame_pacer_wait(FramePacer& pacer)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    
+    // More than a whole frame behind (a hitch, or we were suspended), catching up would just
+    // run a burst of unpaced frames, so drop the missed deadlines instead
+    if(now > pacer.nextDeadline + pacer.period)
+    {
+        frame_pacer_reset(pacer);
+        return;
+    }
+    
+    // Sleep in whole milliseconds while there's plenty of time left...
+    while(now + pacer.spinMargin < pacer.nextDeadline)
+    {
+        Uint64 sleepCounts = pacer.nextDeadline - now - pacer.spinMargin;
+        Uint32 sleepMs = (Uint32)(sleepCounts * 1000 / pacer.frequency);
+        if(sleepMs == 0) break;
+        
+        SDL_Delay(sleepMs);
+        now = SDL_GetPerformanceCounter();
+    }
+    
+    // ...then spin the last fraction
+    while(now < pacer.nextDeadline)
+    {
+        now = SDL_GetPerformanceCounter();
+    }
+    
+    frame_pacer_advance(pacer);
+}
@@ -0,0 +1,33 @@
+#ifndef PACER_H
+#define PACER_H
+
+#include "SDL.h"
+
+// Below this much time left we stop trusting SDL_Delay and spin on the performance counter
+const int PACER_SPIN_MARGIN_US = 2000;
+
+// Paces frames to an exact rate on the performance counter. Deadlines are absolute
+// (start + n * period, with the fractional part of the period carried along), so oversleeping
+// one frame shortens the next and the long run rate doesn't drift.
+struct FramePacer
+{
+    Uint64 frequency;
+    int framesPerSecond;
+    
+    Uint64 period;          // whole counts per frame
+    Uint64 periodRemainder; // frequency % framesPerSecond, carried in 1/framesPerSecond counts
+    Uint64 remainderAccumulator;
+    
+    Uint64 spinMargin;
+    Uint64 nextDeadline;
+};
+
+void frame_pacer_init(FramePacer& pacer, int framesPerSecond);
+
+// Start pacing again from now, e.g. after the loop was suspended
+void frame_pacer_reset(FramePacer& pacer);
+
+// Blocks until the end of the current frame
+void frame_pacer_wait(FramePacer& pacer);
+
+#endif
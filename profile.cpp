@@ -0,0 +1,54 @@
+#include "profile.h"
+
+Profiler gProfiler;
+
+const char* gProfileScopeNames[PROFILE_SCOPE_COUNT] =
+{
+    "Events",
+    "Paddle",
+    "Balls",
+    "Text",
+    "Render",
+    "Present",
+    "Sleep",
+};
+
+void profile_frame_begin()
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    
+    if(gProfiler.frequency == 0)
+    {
+        gProfiler.frequency = SDL_GetPerformanceFrequency();
+        gProfiler.frames[gProfiler.current].start = now;
+        return;
+    }
+    
+    ProfileFrame& finished = gProfiler.frames[gProfiler.current];
+    finished.total = now - finished.start;
+    
+    if(gTraceWriter.active) trace_event(PROFILE_SCOPE_COUNT, finished.start, now);
+    
+    if(gProfiler.numFrames < PROFILE_MAX_FRAMES - 1) ++gProfiler.numFrames;
+    
+    gProfiler.current = (gProfiler.current + 1) % PROFILE_MAX_FRAMES;
+    
+    ProfileFrame& next = gProfiler.frames[gProfiler.current];
+    next = ProfileFrame();
+    next.start = now;
+}
+
+ProfileFrame& profile_frame(int age)
+{
+    int index = gProfiler.current - gProfiler.numFrames + age;
+    if(index < 0) index += PROFILE_MAX_FRAMES;
+    
+    return gProfiler.frames[index];
+}
+
+double profile_ms(Uint64 counts)
+{
+    if(gProfiler.frequency == 0) return 0.0;
+    
+    return (double)counts * 1000.0 / (double)gProfiler.frequency;
+}
@@ -0,0 +1,82 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "SDL_timer.h"
+
+#include "trace.h"
+
+// Per-frame CPU profiler. Scopes are a fixed enum rather than strings so a scope is just two
+// performance counter reads and an add, and the last PROFILE_MAX_FRAMES frames are kept in a ring.
+// Only the main thread may open scopes. While a trace is running every scope is also sent to it.
+// Build with BREAKOUT_PROFILE defined to turn it on, without it PROFILE_SCOPE and PROFILE_FRAME
+// compile to nothing.
+
+enum ProfileScope
+{
+    PROFILE_EVENTS,
+    PROFILE_PADDLE,
+    PROFILE_BALLS, // movement and collision
+    PROFILE_TEXT,
+    PROFILE_RENDER,
+    PROFILE_PRESENT,
+    PROFILE_SLEEP,
+    
+    PROFILE_SCOPE_COUNT
+};
+
+const int PROFILE_MAX_FRAMES = 128;
+
+struct ProfileFrame
+{
+    Uint64 start;
+    Uint64 total; // filled in when the next frame starts
+    Uint64 scopes[PROFILE_SCOPE_COUNT];
+};
+
+struct Profiler
+{
+    Uint64 frequency;
+    
+    ProfileFrame frames[PROFILE_MAX_FRAMES];
+    int current;   // frame being recorded
+    int numFrames; // finished frames in the ring, up to PROFILE_MAX_FRAMES - 1
+};
+
+extern Profiler gProfiler;
+
+extern const char* gProfileScopeNames[PROFILE_SCOPE_COUNT];
+
+// Ends the current frame and starts recording the next
+void profile_frame_begin();
+
+// Finished frames, 0 is the oldest
+ProfileFrame& profile_frame(int age);
+
+double profile_ms(Uint64 counts);
+
+struct ProfileTimer
+{
+    ProfileScope scope;
+    Uint64 start;
+    
+    ProfileTimer(ProfileScope scope) : scope(scope), start(SDL_GetPerformanceCounter()) {}
+    ~ProfileTimer()
+    {
+        Uint64 end = SDL_GetPerformanceCounter();
+        gProfiler.frames[gProfiler.current].scopes[scope] += end - start;
+        
+        if(gTraceWriter.active) trace_event(scope, start, end);
+    }
+};
+
+#ifdef BREAKOUT_PROFILE
+#define PROFILE_JOIN2(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN2(a, b)
+#define PROFILE_SCOPE(scope) ProfileTimer PROFILE_JOIN(profileTimer, __LINE__)(scope)
+#define PROFILE_FRAME() profile_frame_begin()
+#else
+#define PROFILE_SCOPE(scope)
+#define PROFILE_FRAME()
+#endif
+
+#endif
@@ -0,0 +1,450 @@
+#include "render.h"
+
+#include <stdio.h>
+
+RenderStats gRenderStats;
+
+static const SDL_Color gClearColor = {0xFF, 0xFF, 0xFF, 0xFF};
+static const SDL_Color gPaddleColor = {0x00, 0x00, 0x00, 0xFF};
+static const SDL_Color gBallColor = {0x00, 0xFF, 0x00, 0xFF};
+
+void render_stats_reset()
+{
+    gRenderStats.drawCalls = 0;
+}
+
+void render_fill_rect(SDL_Renderer* renderer, SDL_Color color, const SDL_Rect* rect)
+{
+    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+    SDL_RenderFillRect(renderer, rect);
+    ++gRenderStats.drawCalls;
+}
+
+void render_copy(SDL_Renderer* renderer, SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect* dst)
+{
+    SDL_RenderCopy(renderer, texture, src, dst);
+    ++gRenderStats.drawCalls;
+}
+
+void render_batch_begin(RenderBatch& batch)
+{
+    for(int i = 0; i < batch.numColors; ++i)
+    {
+        batch.rects[i].clear();
+    }
+    
+    batch.numColors = 0;
+}
+
+void render_batch_add_rect(RenderBatch& batch, SDL_Color color, const SDL_Rect& rect)
+{
+    int colorIndex = 0;
+    for(; colorIndex < batch.numColors; ++colorIndex)
+    {
+        SDL_Color c = batch.colors[colorIndex];
+        if(c.r == color.r && c.g == color.g && c.b == color.b && c.a == color.a)
+        {
+            break;
+        }
+    }
+    
+    if(colorIndex == batch.numColors)
+    {
+        if(batch.numColors == RENDER_BATCH_MAX_COLORS)
+        {
+            // Once, this is called for every rect every frame
+            static bool warned = false;
+            if(!warned)
+            {
+                printf("Render batch is out of colors! Dropping rects\n");
+                warned = true;
+            }
+            return;
+        }
+        
+        batch.colors[colorIndex] = color;
+        batch.rects[colorIndex].clear();
+        ++batch.numColors;
+    }
+    
+    batch.rects[colorIndex].push_back(rect);
+}
+
+void render_batch_submit(SDL_Renderer* renderer, RenderBatch& batch)
+{
+    for(int i = 0; i < batch.numColors; ++i)
+    {
+        if(batch.rects[i].empty()) continue;
+        
+        SDL_Color color = batch.colors[i];
+        SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+        SDL_RenderFillRects(renderer, batch.rects[i].data(), (int)batch.rects[i].size());
+        ++gRenderStats.drawCalls;
+    }
+}
+
+void block_store_batch(RenderBatch& batch, BlockStore& store, SDL_Color* colors)
+{
+    for(int word = 0; word * 64 < store.numBlocks; ++word)
+    {
+        Uint64 bits = block_active_bits(store, word);
+        while(bits)
+        {
+            int i = word * 64 + bit_scan_forward(bits);
+            bits &= bits - 1;
+            
+            render_batch_add_rect(batch, colors[store.color[i]], block_collider(store, i));
+        }
+    }
+}
+
+void dirty_rects_reset(DirtyRects& dirty)
+{
+    dirty.numRects = 0;
+    dirty.full = false;
+}
+
+void dirty_rects_add(DirtyRects& dirty, SDL_Rect rect)
+{
+    if(dirty.full || rect.w <= 0 || rect.h <= 0) return;
+    
+    // Anything this touches gets folded in, which can make it touch rects it didn't before
+    for(int i = 0; i < dirty.numRects; )
+    {
+        if(SDL_HasIntersection(&rect, &dirty.rects[i]))
+        {
+            SDL_UnionRect(&rect, &dirty.rects[i], &rect);
+            dirty.rects[i] = dirty.rects[--dirty.numRects];
+            i = 0;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+    
+    if(dirty.numRects == DIRTY_RECTS_MAX)
+    {
+        dirty.full = true;
+        return;
+    }
+    
+    dirty.rects[dirty.numRects++] = rect;
+}
+
+// The part of every active block inside area
+static void block_store_batch_area(RenderBatch& batch, World& world, SDL_Rect area)
+{
+    BlockStore& blocks = world.blocks;
+    for(int word = 0; word * 64 < blocks.numBlocks; ++word)
+    {
+        Uint64 bits = block_active_bits(blocks, word) & block_overlap_word(blocks, word, area);
+        while(bits)
+        {
+            int i = word * 64 + bit_scan_forward(bits);
+            bits &= bits - 1;
+            
+            SDL_Rect block = block_collider(blocks, i);
+            SDL_Rect part;
+            if(SDL_IntersectRect(&block, &area, &part))
+            {
+                render_batch_add_rect(batch, world.colors[blocks.color[i]], part);
+            }
+        }
+    }
+}
+
+// Whatever part of rect is inside the dirty rects, into the batch
+static void dirty_rects_batch(DirtyRects& dirty, RenderBatch& batch, SDL_Color color, SDL_Rect rect)
+{
+    for(int i = 0; i < dirty.numRects; ++i)
+    {
+        SDL_Rect part;
+        if(SDL_IntersectRect(&rect, &dirty.rects[i], &part))
+        {
+            render_batch_add_rect(batch, color, part);
+        }
+    }
+}
+
+static void world_render_remember(WorldRenderer& worldRenderer, World& world, SDL_Rect paddleCollider, float alpha)
+{
+    worldRenderer.drawn = true;
+    worldRenderer.drawnWidth = world.width;
+    worldRenderer.drawnHeight = world.height;
+    worldRenderer.drawnPaddle = paddleCollider;
+    
+    worldRenderer.drawnBalls.resize(world.balls.numBalls);
+    for(int i = 0; i < world.balls.numBalls; ++i)
+    {
+        worldRenderer.drawnBalls[i] = ball_pool_interpolate(world.balls, i, alpha);
+    }
+    
+    int numWords = (world.blocks.numBlocks + 63) / 64;
+    worldRenderer.drawnActive.resize(numWords);
+    for(int word = 0; word < numWords; ++word)
+    {
+        worldRenderer.drawnActive[word] = block_active_bits(world.blocks, word);
+    }
+}
+
+void world_renderer_destroy(WorldRenderer& worldRenderer)
+{
+    if(worldRenderer.blockLayer) SDL_DestroyTexture(worldRenderer.blockLayer);
+    worldRenderer.blockLayer = NULL;
+    worldRenderer.blockLayerValid = false;
+    worldRenderer.blockLayerUnsupported = false;
+}
+
+void world_renderer_invalidate(WorldRenderer& worldRenderer)
+{
+    worldRenderer.blockLayerValid = false;
+}
+
+// Brings the block layer up to date with the world, making it if need be. Returns false if there
+// isn't one and the blocks have to be drawn directly.
+static bool block_layer_update(SDL_Renderer* renderer, WorldRenderer& worldRenderer, World& world)
+{
+    if(worldRenderer.blockLayerUnsupported) return false;
+    
+    if(worldRenderer.blockLayer == NULL || worldRenderer.blockLayerWidth != world.width || worldRenderer.blockLayerHeight != world.height)
+    {
+        if(worldRenderer.blockLayer) SDL_DestroyTexture(worldRenderer.blockLayer);
+        worldRenderer.blockLayer = NULL;
+        worldRenderer.blockLayerValid = false;
+        
+        if(world.width <= 0 || world.height <= 0) return false;
+        
+        if(SDL_RenderTargetSupported(renderer))
+        {
+            worldRenderer.blockLayer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, world.width, world.height);
+        }
+        
+        if(worldRenderer.blockLayer == NULL)
+        {
+            printf("Block layer could not be created, drawing blocks directly! SDL Error: %s\n", SDL_GetError());
+            worldRenderer.blockLayerUnsupported = true;
+            return false;
+        }
+        
+        // Opaque, it's copied over whatever was there rather than blended
+        SDL_SetTextureBlendMode(worldRenderer.blockLayer, SDL_BLENDMODE_NONE);
+        worldRenderer.blockLayerWidth = world.width;
+        worldRenderer.blockLayerHeight = world.height;
+    }
+    
+    BlockStore& blocks = world.blocks;
+    int numWords = (blocks.numBlocks + 63) / 64;
+    std::vector<Uint64>& layerActive = worldRenderer.blockLayerActive;
+    
+    // Blocks only ever die in play, one coming back (a new level, a snapshot loaded) means starting over
+    bool rebuild = !worldRenderer.blockLayerValid || (int)layerActive.size() != numWords;
+    bool died = false;
+    for(int word = 0; word < numWords && !rebuild; ++word)
+    {
+        Uint64 active = block_active_bits(blocks, word);
+        rebuild = (active & ~layerActive[word]) != 0;
+        died = died || active != layerActive[word];
+    }
+    
+    if(!rebuild && !died) return true;
+    
+    SDL_SetRenderTarget(renderer, worldRenderer.blockLayer);
+    
+    RenderBatch& blockBatch = worldRenderer.blockBatch;
+    if(rebuild)
+    {
+        SDL_SetRenderDrawColor(renderer, gClearColor.r, gClearColor.g, gClearColor.b, gClearColor.a);
+        SDL_RenderClear(renderer);
+        
+        render_batch_begin(blockBatch);
+        block_store_batch(blockBatch, blocks, world.colors);
+        render_batch_submit(renderer, blockBatch);
+        
+        layerActive.resize(numWords);
+        worldRenderer.blockLayerValid = true;
+    }
+    else
+    {
+        // Erase each dead block, then put back any part of a live one it overlapped
+        render_batch_begin(blockBatch);
+        for(int word = 0; word < numWords; ++word)
+        {
+            Uint64 dead = layerActive[word] & ~block_active_bits(blocks, word);
+            while(dead)
+            {
+                int i = word * 64 + bit_scan_forward(dead);
+                dead &= dead - 1;
+                
+                render_batch_add_rect(blockBatch, gClearColor, block_collider(blocks, i));
+            }
+        }
+        render_batch_submit(renderer, blockBatch);
+        
+        render_batch_begin(blockBatch);
+        for(int word = 0; word < numWords; ++word)
+        {
+            Uint64 dead = layerActive[word] & ~block_active_bits(blocks, word);
+            while(dead)
+            {
+                int i = word * 64 + bit_scan_forward(dead);
+                dead &= dead - 1;
+                
+                block_store_batch_area(blockBatch, world, block_collider(blocks, i));
+            }
+        }
+        render_batch_submit(renderer, blockBatch);
+    }
+    
+    for(int word = 0; word < numWords; ++word)
+    {
+        layerActive[word] = block_active_bits(blocks, word);
+    }
+    
+    SDL_SetRenderTarget(renderer, NULL);
+    
+    return true;
+}
+
+void world_render(SDL_Renderer* renderer, WorldRenderer& worldRenderer, World& world, SDL_Rect paddleCollider, float alpha)
+{
+    // The layer has the clear color behind the blocks and covers the whole world, so it clears too
+    if(block_layer_update(renderer, worldRenderer, world))
+    {
+        SDL_Rect layerRect = {0, 0, worldRenderer.blockLayerWidth, worldRenderer.blockLayerHeight};
+        render_copy(renderer, worldRenderer.blockLayer, NULL, &layerRect);
+    }
+    else
+    {
+        SDL_SetRenderDrawColor(renderer, gClearColor.r, gClearColor.g, gClearColor.b, gClearColor.a);
+        SDL_RenderClear(renderer);
+        
+        RenderBatch& blockBatch = worldRenderer.blockBatch;
+        render_batch_begin(blockBatch);
+        block_store_batch(blockBatch, world.blocks, world.colors);
+        render_batch_submit(renderer, blockBatch);
+    }
+    
+    render_fill_rect(renderer, gPaddleColor, &paddleCollider);
+    
+    RenderBatch& ballBatch = worldRenderer.ballBatch;
+    render_batch_begin(ballBatch);
+    for(int i = 0; i < world.balls.numBalls; ++i)
+    {
+        render_batch_add_rect(ballBatch, gBallColor, ball_pool_interpolate(world.balls, i, alpha));
+    }
+    render_batch_submit(renderer, ballBatch);
+}
+
+void world_render_dirty(SDL_Renderer* renderer, WorldRenderer& worldRenderer, World& world, SDL_Rect paddleCollider, float alpha,
+                        DirtyRects& dirty)
+{
+    BlockStore& blocks = world.blocks;
+    int numWords = (blocks.numBlocks + 63) / 64;
+    
+    if(!worldRenderer.drawn || worldRenderer.drawnWidth != world.width || worldRenderer.drawnHeight != world.height ||
+       (int)worldRenderer.drawnActive.size() != numWords)
+    {
+        dirty.full = true;
+    }
+    
+    if(!dirty.full)
+    {
+        if(!SDL_RectEquals(&paddleCollider, &worldRenderer.drawnPaddle))
+        {
+            dirty_rects_add(dirty, worldRenderer.drawnPaddle);
+            dirty_rects_add(dirty, paddleCollider);
+        }
+        
+        int numDrawnBalls = (int)worldRenderer.drawnBalls.size();
+        for(int i = 0; i < world.balls.numBalls || i < numDrawnBalls; ++i)
+        {
+            SDL_Rect ball = {};
+            if(i < world.balls.numBalls) ball = ball_pool_interpolate(world.balls, i, alpha);
+            
+            if(i >= numDrawnBalls)
+            {
+                dirty_rects_add(dirty, ball);
+            }
+            else if(!SDL_RectEquals(&ball, &worldRenderer.drawnBalls[i]))
+            {
+                dirty_rects_add(dirty, worldRenderer.drawnBalls[i]);
+                dirty_rects_add(dirty, ball);
+            }
+        }
+        
+        for(int word = 0; word < numWords; ++word)
+        {
+            Uint64 changed = worldRenderer.drawnActive[word] ^ block_active_bits(blocks, word);
+            while(changed)
+            {
+                int i = word * 64 + bit_scan_forward(changed);
+                changed &= changed - 1;
+                
+                dirty_rects_add(dirty, block_collider(blocks, i));
+            }
+        }
+    }
+    
+    if(dirty.full)
+    {
+        world_render(renderer, worldRenderer, world, paddleCollider, alpha);
+        world_render_remember(worldRenderer, world, paddleCollider, alpha);
+        return;
+    }
+    
+    // Balls and the paddle can hang off the edge, only what's on screen gets drawn and presented
+    SDL_Rect screen = {0, 0, world.width, world.height};
+    for(int i = 0; i < dirty.numRects; )
+    {
+        SDL_Rect onScreen;
+        if(SDL_IntersectRect(&dirty.rects[i], &screen, &onScreen))
+        {
+            dirty.rects[i++] = onScreen;
+        }
+        else
+        {
+            dirty.rects[i] = dirty.rects[--dirty.numRects];
+        }
+    }
+    
+    if(dirty.numRects == 0) return;
+    
+    // Same layers as world_render, each clipped to the dirty rects. They never overlap each other,
+    // so one batch per layer covers all of them. With the block layer the background and blocks
+    // are a copy out of it per rect.
+    if(block_layer_update(renderer, worldRenderer, world))
+    {
+        for(int r = 0; r < dirty.numRects; ++r)
+        {
+            render_copy(renderer, worldRenderer.blockLayer, &dirty.rects[r], &dirty.rects[r]);
+        }
+    }
+    else
+    {
+        SDL_SetRenderDrawColor(renderer, gClearColor.r, gClearColor.g, gClearColor.b, gClearColor.a);
+        SDL_RenderFillRects(renderer, dirty.rects, dirty.numRects);
+        ++gRenderStats.drawCalls;
+        
+        RenderBatch& blockBatch = worldRenderer.blockBatch;
+        render_batch_begin(blockBatch);
+        for(int r = 0; r < dirty.numRects; ++r)
+        {
+            block_store_batch_area(blockBatch, world, dirty.rects[r]);
+        }
+        render_batch_submit(renderer, blockBatch);
+    }
+    
+    // The paddle rides along in the ball batch, colors are submitted in the order they were added
+    // so it still ends up under the balls
+    RenderBatch& ballBatch = worldRenderer.ballBatch;
+    render_batch_begin(ballBatch);
+    dirty_rects_batch(dirty, ballBatch, gPaddleColor, paddleCollider);
+    for(int i = 0; i < world.balls.numBalls; ++i)
+    {
+        dirty_rects_batch(dirty, ballBatch, gBallColor, ball_pool_interpolate(world.balls, i, alpha));
+    }
+    render_batch_submit(renderer, ballBatch);
+    
+    world_render_remember(worldRenderer, world, paddleCollider, alpha);
+}
@@ -0,0 +1,101 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "SDL.h"
+
+#include "simulation.h"
+
+#include <vector>
+
+// Every color of the level plus the background and paddle, so world rendering never runs out.
+// The profile overlay fits too, one color per scope and one for the rest.
+const int RENDER_BATCH_MAX_COLORS = WORLD_MAX_COLORS + 2;
+
+// Rects gathered per color so each color is submitted with a single SDL_RenderFillRects
+struct RenderBatch
+{
+    SDL_Color colors[RENDER_BATCH_MAX_COLORS];
+    std::vector<SDL_Rect> rects[RENDER_BATCH_MAX_COLORS];
+    int numColors;
+};
+
+struct RenderStats
+{
+    int drawCalls;
+};
+
+// Every SDL draw call we issue is counted here, reset once per frame
+extern RenderStats gRenderStats;
+
+void render_stats_reset();
+
+void render_fill_rect(SDL_Renderer* renderer, SDL_Color color, const SDL_Rect* rect);
+void render_copy(SDL_Renderer* renderer, SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect* dst);
+
+// Clears the batch but keeps the storage, so steady state batching doesn't allocate
+void render_batch_begin(RenderBatch& batch);
+void render_batch_add_rect(RenderBatch& batch, SDL_Color color, const SDL_Rect& rect);
+void render_batch_submit(SDL_Renderer* renderer, RenderBatch& batch);
+
+// Every active block, in the color its color index picks out of colors
+void block_store_batch(RenderBatch& batch, BlockStore& store, SDL_Color* colors);
+
+const int DIRTY_RECTS_MAX = 32;
+
+// Parts of the screen that have to be redrawn and presented this frame. Overlapping rects are merged
+// as they're added so no pixel is drawn twice, and past DIRTY_RECTS_MAX it gives up and goes full.
+struct DirtyRects
+{
+    SDL_Rect rects[DIRTY_RECTS_MAX];
+    int numRects;
+    bool full;
+};
+
+void dirty_rects_reset(DirtyRects& dirty);
+void dirty_rects_add(DirtyRects& dirty, SDL_Rect rect);
+
+// Batches kept between frames so drawing the world doesn't allocate once they've grown
+struct WorldRenderer
+{
+    RenderBatch blockBatch;
+    RenderBatch ballBatch;
+    
+    // The blocks drawn once into a target texture the size of the world, with the clear color behind
+    // them, then only patched where a block died. Drawing the blocks is one copy however many there are.
+    // blockLayerActive is the alive bits the texture was last brought up to date with.
+    SDL_Texture* blockLayer;
+    int blockLayerWidth;
+    int blockLayerHeight;
+    bool blockLayerValid;
+    bool blockLayerUnsupported; // no render targets, blocks are drawn every frame instead
+    std::vector<Uint64> blockLayerActive;
+    
+    // What world_render_dirty last left on screen, so the next frame knows what moved or died
+    bool drawn;
+    int drawnWidth;
+    int drawnHeight;
+    SDL_Rect drawnPaddle;
+    std::vector<SDL_Rect> drawnBalls;
+    std::vector<Uint64> drawnActive;
+};
+
+// Frees the block layer, before the renderer it was made with goes away
+void world_renderer_destroy(WorldRenderer& worldRenderer);
+
+// Redraws the block layer from scratch next frame, for when SDL says render targets were lost
+// (SDL_RENDER_TARGETS_RESET, SDL_RENDER_DEVICE_RESET)
+void world_renderer_invalidate(WorldRenderer& worldRenderer);
+
+// Clears and draws the blocks, paddle and balls, alpha is how far between the last two ticks to draw the balls.
+// Shared by the game, the render regression harness and the render benchmark.
+void world_render(SDL_Renderer* renderer, WorldRenderer& worldRenderer, World& world, SDL_Rect paddleCollider, float alpha);
+
+// Same picture as world_render, but only redraws what changed since the last call: the paddle and
+// balls where they were and where they are now, and any block that died. Those are added to dirty
+// on top of whatever the caller already put there (the HUD), and everything in dirty is redrawn.
+// Goes full the first time, when the world was resized, or when the caller set dirty.full, so after
+// this dirty is exactly what has to be presented.
+void world_render_dirty(SDL_Renderer* renderer, WorldRenderer& worldRenderer, World& world, SDL_Rect paddleCollider, float alpha,
+                        DirtyRects& dirty);
+
+#endif
@@ -0,0 +1,256 @@
+// Renders a scripted session with the software renderer into an offscreen surface, no display or
+// GPU needed, and checks selected frames against golden PNGs by CRC of their pixels.
+//
+//     render_regression           compare against goldens/, exits non zero on any mismatch
+//     render_regression --bless   (re)write goldens/ from this build
+//     render_regression --dirty-rects
+//                                 draw with world_render_dirty instead, it has to match the same goldens
+//
+// goldens/ is the one in the repo: CMake passes its path in as BREAKOUT_GOLDEN_DIR, without it
+// (build.bat) it's found from the executable in build/. Every compared frame is also written next
+// to the executable as render_frame_NNNN.png so a failure can be diffed by eye. The HUD text isn't
+// drawn, glyph rasterization changes between FreeType versions and would make the goldens machine
+// dependent.
+
+#include "SDL.h"
+#include <SDL_image.h>
+
+#include "simulation.h"
+#include "render.h"
+
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+const int REGRESSION_WIDTH = 640;
+const int REGRESSION_HEIGHT = 480;
+const int REGRESSION_NUM_TICKS = 1200;
+
+// Ticks whose frame is compared. At 54 the ball bounces off a bottom row block and kills it, so the
+// frame has the ball's old and new rects and the dead block to redraw at once, which --dirty-rects has
+// to get right in a single pass. By 940 four neighbouring blocks of the middle row have died, the
+// block layer has to have erased each of them without touching the ones around it.
+const int gRegressionFrames[] = {0, 30, 54, 120, 300, 600, 900, 940, 1200};
+const int REGRESSION_NUM_FRAMES = sizeof(gRegressionFrames) / sizeof(gRegressionFrames[0]);
+
+static Uint32 crc32_update(Uint32 crc, const Uint8* data, int size)
+{
+    static Uint32 table[256];
+    if(table[1] == 0)
+    {
+        for(Uint32 i = 0; i < 256; ++i)
+        {
+            Uint32 c = i;
+            for(int bit = 0; bit < 8; ++bit)
+            {
+                c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            }
+            
+            table[i] = c;
+        }
+    }
+    
+    crc = ~crc;
+    for(int i = 0; i < size; ++i)
+    {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    
+    return ~crc;
+}
+
+// Only the visible pixels, not the pitch padding. The surface must be RGBA32.
+static Uint32 surface_crc32(SDL_Surface* surface)
+{
+    Uint32 crc = 0;
+    
+    SDL_LockSurface(surface);
+    for(int y = 0; y < surface->h; ++y)
+    {
+        crc = crc32_update(crc, (Uint8*)surface->pixels + y * surface->pitch, surface->w * 4);
+    }
+    SDL_UnlockSurface(surface);
+    
+    return crc;
+}
+
+// Returns false if the golden doesn't exist or can't be read
+static bool golden_crc32(const char* path, int width, int height, Uint32& crc)
+{
+    SDL_Surface* loaded = IMG_Load(path);
+    if(loaded == NULL) return false;
+    
+    SDL_Surface* converted = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(loaded);
+    if(converted == NULL) return false;
+    
+    bool success = converted->w == width && converted->h == height;
+    if(success) crc = surface_crc32(converted);
+    
+    SDL_FreeSurface(converted);
+    
+    return success;
+}
+
+static void make_directory(const char* path)
+{
+#ifdef _WIN32
+    _mkdir(path);
+#else
+    mkdir(path, 0755);
+#endif
+}
+
+#undef main
+int main(int argc, char *argv[])
+{
+    bool bless = false;
+    bool dirtyRects = false;
+    for(int i = 1; i < argc; ++i)
+    {
+        if(SDL_strcmp(argv[i], "--bless") == 0) bless = true;
+        if(SDL_strcmp(argv[i], "--dirty-rects") == 0) dirtyRects = true;
+    }
+    
+    // No display on CI, the software renderer doesn't need one anyway. SDL 2.0.9 has no hint for
+    // this, it reads the environment, overwrite = 0 so a driver set from outside still wins.
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+    
+    if(SDL_Init(SDL_INIT_VIDEO) < 0)
+    {
+        printf("SDL could not init! SDL_Error: %s\n", SDL_GetError());
+        return 1;
+    }
+    
+    if(!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG))
+    {
+        printf("SDL_image could not initialize! SDL_image error: %s\n", IMG_GetError());
+        return 1;
+    }
+    
+    SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, REGRESSION_WIDTH, REGRESSION_HEIGHT, 32, SDL_PIXELFORMAT_RGBA32);
+    SDL_Renderer* renderer = target ? SDL_CreateSoftwareRenderer(target) : NULL;
+    if(renderer == NULL)
+    {
+        printf("Software renderer could not be created! SDL Error: %s\n", SDL_GetError());
+        return 1;
+    }
+    
+    // Both end in a separator
+    char* basePath = SDL_GetBasePath();
+    if(basePath == NULL)
+    {
+        printf("Unable to find the executable's directory! SDL Error: %s\n", SDL_GetError());
+        return 1;
+    }
+    
+    char goldenDir[1024];
+#ifdef BREAKOUT_GOLDEN_DIR
+    SDL_snprintf(goldenDir, sizeof(goldenDir), "%s", BREAKOUT_GOLDEN_DIR);
+#else
+    SDL_snprintf(goldenDir, sizeof(goldenDir), "%s../goldens/", basePath);
+#endif
+    
+    if(bless) make_directory(goldenDir);
+    
+    World world;
+    world_create(world, REGRESSION_WIDTH, REGRESSION_HEIGHT);
+    
+    WorldRenderer worldRenderer = {};
+    WorldInput input = {};
+    DirtyRects dirty = {};
+    
+    int nextFrame = 0;
+    int numFailed = 0;
+    Uint64 renderCounts = 0;
+    
+    for(int tick = 0; tick <= REGRESSION_NUM_TICKS; ++tick)
+    {
+        if(tick > 0)
+        {
+            // The paddle follows the ball so it's never lost and blocks keep dying up to the last frame
+            BallPool& balls = world.balls;
+            int target = balls.posX[0] + balls.w[0] / 2 - world.paddle.collider.w / 2;
+            input.paddleVelX = clamp(target - world.paddle.posX, -MOVE_VEL, MOVE_VEL);
+            world_step(world, input);
+        }
+        
+        // Every tick is drawn, so the timing covers the render path and not just the captured frames
+        Uint64 start = SDL_GetPerformanceCounter();
+        if(dirtyRects)
+        {
+            dirty_rects_reset(dirty);
+            world_render_dirty(renderer, worldRenderer, world, world.paddle.collider, 1.0f, dirty);
+        }
+        else
+        {
+            world_render(renderer, worldRenderer, world, world.paddle.collider, 1.0f);
+        }
+        SDL_RenderPresent(renderer);
+        renderCounts += SDL_GetPerformanceCounter() - start;
+        
+        if(nextFrame == REGRESSION_NUM_FRAMES || gRegressionFrames[nextFrame] != tick) continue;
+        ++nextFrame;
+        
+        char outPath[1024];
+        char goldenPath[1024];
+        SDL_snprintf(outPath, sizeof(outPath), "%srender_frame_%04d.png", basePath, tick);
+        SDL_snprintf(goldenPath, sizeof(goldenPath), "%srender_frame_%04d.png", goldenDir, tick);
+        
+        Uint32 crc = surface_crc32(target);
+        
+        if(IMG_SavePNG(target, bless ? goldenPath : outPath) != 0)
+        {
+            printf("Unable to save %s! SDL_image Error: %s\n", bless ? goldenPath : outPath, IMG_GetError());
+            ++numFailed;
+            continue;
+        }
+        
+        if(bless)
+        {
+            printf("tick %4d: crc %08x, blessed %s\n", tick, crc, goldenPath);
+            continue;
+        }
+        
+        Uint32 goldenCrc;
+        if(!golden_crc32(goldenPath, REGRESSION_WIDTH, REGRESSION_HEIGHT, goldenCrc))
+        {
+            printf("tick %4d: crc %08x, no usable golden %s (run with --bless to create it)\n", tick, crc, goldenPath);
+            ++numFailed;
+        }
+        else if(crc != goldenCrc)
+        {
+            printf("tick %4d: crc %08x, golden %08x, MISMATCH, see %s\n", tick, crc, goldenCrc, outPath);
+            ++numFailed;
+        }
+        else
+        {
+            printf("tick %4d: crc %08x, ok\n", tick, crc);
+        }
+    }
+    
+    double seconds = (double)renderCounts / (double)SDL_GetPerformanceFrequency();
+    printf("%d frames rendered in %.3f s, %.0f frames/s\n", REGRESSION_NUM_TICKS + 1, seconds, (REGRESSION_NUM_TICKS + 1) / seconds);
+    
+    world_renderer_destroy(worldRenderer);
+    world_destroy(world);
+    
+    SDL_free(basePath);
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(target);
+    
+    IMG_Quit();
+    SDL_Quit();
+    
+    if(numFailed)
+    {
+        printf("%d of %d frames failed\n", numFailed, REGRESSION_NUM_FRAMES);
+        return 1;
+    }
+    
+    return 0;
+}
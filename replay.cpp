@@ -0,0 +1,298 @@
+#include "replay.h"
+
+#include <stdio.h>
+
+static void write_u32(std::vector<Uint8>& out, Uint32 value)
+{
+    for(int i = 0; i < 4; ++i)
+    {
+        out.push_back((Uint8)(value >> (i * 8)));
+    }
+}
+
+static void write_u64(std::vector<Uint8>& out, Uint64 value)
+{
+    for(int i = 0; i < 8; ++i)
+    {
+        out.push_back((Uint8)(value >> (i * 8)));
+    }
+}
+
+static Uint32 read_u32(const Uint8* in)
+{
+    Uint32 value = 0;
+    for(int i = 0; i < 4; ++i)
+    {
+        value |= (Uint32)in[i] << (i * 8);
+    }
+    
+    return value;
+}
+
+static Uint64 read_u64(const Uint8* in)
+{
+    Uint64 value = 0;
+    for(int i = 0; i < 8; ++i)
+    {
+        value |= (Uint64)in[i] << (i * 8);
+    }
+    
+    return value;
+}
+
+// 7 bits per byte, high bit set on every byte but the last
+static void write_varint(std::vector<Uint8>& out, Uint64 value)
+{
+    while(value >= 0x80)
+    {
+        out.push_back((Uint8)(value | 0x80));
+        value >>= 7;
+    }
+    
+    out.push_back((Uint8)value);
+}
+
+static bool read_varint(ReplayPlayer& player, Uint64& value)
+{
+    value = 0;
+    for(int shift = 0; shift < 64; shift += 7)
+    {
+        if(player.readOffset >= player.inputs.size()) return false;
+        
+        Uint8 byte = player.inputs[player.readOffset++];
+        value |= (Uint64)(byte & 0x7F) << shift;
+        
+        if(!(byte & 0x80)) return true;
+    }
+    
+    return false;
+}
+
+// Small negative numbers stay small: 0, -1, 1, -2, 2 ... -> 0, 1, 2, 3, 4 ...
+// All in 32 bits, sign extending into the top half would make every negative value a 10 byte varint.
+// Files written that way still decode the same, zigzag_decode only looks at the low 33 bits.
+static Uint64 zigzag_encode(int value)
+{
+    return (Uint32)(((Uint32)value << 1) ^ (Uint32)(value >> 31));
+}
+
+static int zigzag_decode(Uint64 value)
+{
+    return (int)(Uint32)(value >> 1) ^ -(int)(value & 1);
+}
+
+static const int REPLAY_HEADER_SIZE = 4 * 7 + 8 * 2;
+
+static void replay_header_write(std::vector<Uint8>& out, ReplayHeader& header)
+{
+    write_u32(out, header.magic);
+    write_u32(out, header.version);
+    write_u32(out, header.level);
+    write_u32(out, header.seed);
+    write_u32(out, (Uint32)header.width);
+    write_u32(out, (Uint32)header.height);
+    write_u32(out, header.ticksPerSecond);
+    write_u64(out, header.numTicks);
+    write_u64(out, header.finalHash);
+}
+
+static void replay_header_read(const Uint8* in, ReplayHeader& header)
+{
+    header.magic = read_u32(in + 0);
+    header.version = read_u32(in + 4);
+    header.level = read_u32(in + 8);
+    header.seed = read_u32(in + 12);
+    header.width = (int)read_u32(in + 16);
+    header.height = (int)read_u32(in + 20);
+    header.ticksPerSecond = read_u32(in + 24);
+    header.numTicks = read_u64(in + 28);
+    header.finalHash = read_u64(in + 36);
+}
+
+void replay_recorder_begin(ReplayRecorder& recorder, World& world)
+{
+    recorder.header = {};
+    recorder.header.magic = REPLAY_MAGIC;
+    recorder.header.version = REPLAY_VERSION;
+    recorder.header.width = world.width;
+    recorder.header.height = world.height;
+    recorder.header.ticksPerSecond = WORLD_TICKS_PER_SECOND;
+    
+    recorder.inputs.clear();
+    recorder.inputs.reserve(REPLAY_RECORDER_RESERVE);
+    
+    recorder.last = {};
+    recorder.last.width = world.width;
+    recorder.last.height = world.height;
+    recorder.lastChangeTick = world.tick;
+}
+
+void replay_recorder_tick(ReplayRecorder& recorder, World& world, WorldInput input)
+{
+    Uint32 changed = 0;
+    if(input.paddleVelX != recorder.last.input.paddleVelX) changed |= REPLAY_CHANGED_PADDLE;
+    if(world.width != recorder.last.width || world.height != recorder.last.height) changed |= REPLAY_CHANGED_SIZE;
+    
+    if(changed)
+    {
+        write_varint(recorder.inputs, world.tick - recorder.lastChangeTick);
+        write_varint(recorder.inputs, changed);
+        
+        if(changed & REPLAY_CHANGED_PADDLE)
+        {
+            write_varint(recorder.inputs, zigzag_encode(input.paddleVelX));
+        }
+        
+        if(changed & REPLAY_CHANGED_SIZE)
+        {
+            write_varint(recorder.inputs, (Uint32)world.width);
+            write_varint(recorder.inputs, (Uint32)world.height);
+        }
+        
+        recorder.last.input = input;
+        recorder.last.width = world.width;
+        recorder.last.height = world.height;
+        recorder.lastChangeTick = world.tick;
+    }
+    
+    recorder.header.numTicks = world.tick + 1;
+}
+
+bool replay_recorder_save(ReplayRecorder& recorder, World& world, const char* path)
+{
+    recorder.header.finalHash = world_hash(world);
+    
+    std::vector<Uint8> header;
+    replay_header_write(header, recorder.header);
+    
+    FILE* file = fopen(path, "wb");
+    if(file == NULL)
+    {
+        printf("Unable to open replay %s for writing!\n", path);
+        return false;
+    }
+    
+    bool success = fwrite(header.data(), 1, header.size(), file) == header.size();
+    if(success && !recorder.inputs.empty())
+    {
+        success = fwrite(recorder.inputs.data(), 1, recorder.inputs.size(), file) == recorder.inputs.size();
+    }
+    
+    if(fclose(file) != 0) success = false;
+    
+    if(!success)
+    {
+        printf("Unable to write replay %s!\n", path);
+    }
+    
+    return success;
+}
+
+// Returns false if the inputs end part way through a varint
+static bool replay_player_read_change(ReplayPlayer& player)
+{
+    if(player.readOffset == player.inputs.size())
+    {
+        player.nextChangeTick = ~(Uint64)0;
+        return true;
+    }
+    
+    Uint64 delta;
+    if(!read_varint(player, delta)) return false;
+    
+    player.nextChangeTick = player.tick + delta;
+    
+    return true;
+}
+
+bool replay_player_load(ReplayPlayer& player, const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if(file == NULL)
+    {
+        printf("Unable to open replay %s!\n", path);
+        return false;
+    }
+    
+    Uint8 headerBytes[REPLAY_HEADER_SIZE];
+    if(fread(headerBytes, 1, REPLAY_HEADER_SIZE, file) != REPLAY_HEADER_SIZE)
+    {
+        printf("Replay %s is too short to have a header!\n", path);
+        fclose(file);
+        return false;
+    }
+    
+    replay_header_read(headerBytes, player.header);
+    if(player.header.magic != REPLAY_MAGIC || player.header.version != REPLAY_VERSION)
+    {
+        printf("%s isn't a version %u replay!\n", path, REPLAY_VERSION);
+        fclose(file);
+        return false;
+    }
+    
+    player.inputs.clear();
+    
+    Uint8 buffer[4096];
+    size_t numRead;
+    while((numRead = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        player.inputs.insert(player.inputs.end(), buffer, buffer + numRead);
+    }
+    
+    fclose(file);
+    
+    player.readOffset = 0;
+    player.current = {};
+    player.current.width = player.header.width;
+    player.current.height = player.header.height;
+    player.tick = 0;
+    
+    if(!replay_player_read_change(player))
+    {
+        printf("Replay %s is corrupt!\n", path);
+        return false;
+    }
+    
+    return true;
+}
+
+bool replay_player_tick(ReplayPlayer& player, World& world, WorldInput& input)
+{
+    if(player.tick >= player.header.numTicks) return false;
+    
+    if(player.tick == player.nextChangeTick)
+    {
+        // A record always changes something the recorder knows about
+        Uint64 changed;
+        if(!read_varint(player, changed) || changed == 0 || (changed & ~(Uint64)(REPLAY_CHANGED_PADDLE | REPLAY_CHANGED_SIZE)))
+        {
+            return false;
+        }
+        
+        Uint64 value;
+        if(changed & REPLAY_CHANGED_PADDLE)
+        {
+            if(!read_varint(player, value)) return false;
+            player.current.input.paddleVelX = zigzag_decode(value);
+        }
+        
+        if(changed & REPLAY_CHANGED_SIZE)
+        {
+            if(!read_varint(player, value)) return false;
+            player.current.width = (int)value;
+            
+            if(!read_varint(player, value)) return false;
+            player.current.height = (int)value;
+        }
+        
+        if(!replay_player_read_change(player)) return false;
+    }
+    
+    world.width = player.current.width;
+    world.height = player.current.height;
+    input = player.current.input;
+    
+    ++player.tick;
+    
+    return true;
+}
@@ -0,0 +1,89 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "SDL.h"
+
+#include "simulation.h"
+
+#include <vector>
+
+// Replay file layout, all little endian:
+//
+//     header    ReplayHeader, fixed size fields written one by one (see replay.cpp)
+//     inputs    one record per tick where the input changed:
+//                   varint ticks since the previous record
+//                   varint mask of REPLAY_CHANGED_* bits
+//                   zigzag varint paddleVelX      if REPLAY_CHANGED_PADDLE
+//                   varint width, varint height   if REPLAY_CHANGED_SIZE
+//
+// The window size is part of the input since the world is resized to fit the window.
+
+const Uint32 REPLAY_MAGIC = 0x50524B42; // "BKRP"
+const Uint32 REPLAY_VERSION = 1;
+
+const Uint32 REPLAY_CHANGED_PADDLE = 1 << 0;
+const Uint32 REPLAY_CHANGED_SIZE = 1 << 1;
+
+struct ReplayHeader
+{
+    Uint32 magic;
+    Uint32 version;
+    
+    // Id of the compiled level (level.h), 0 for the built in one. Nothing is random yet so seed is 0
+    Uint32 level;
+    Uint32 seed;
+    
+    int width;
+    int height;
+    Uint32 ticksPerSecond;
+    
+    Uint64 numTicks;
+    Uint64 finalHash; // world_hash after the last tick, checked on playback
+};
+
+// The state a tick is stepped with
+struct ReplayTick
+{
+    WorldInput input;
+    int width;
+    int height;
+};
+
+// An hour of the input changing every tick is ~650 KB, reserved up front so recording doesn't allocate mid game
+const size_t REPLAY_RECORDER_RESERVE = 1 << 20;
+
+struct ReplayRecorder
+{
+    ReplayHeader header;
+    std::vector<Uint8> inputs;
+    
+    ReplayTick last;
+    Uint64 lastChangeTick;
+};
+
+struct ReplayPlayer
+{
+    ReplayHeader header;
+    std::vector<Uint8> inputs;
+    size_t readOffset;
+    
+    ReplayTick current;
+    Uint64 tick;
+    Uint64 nextChangeTick; // ~0 once there are no more records
+};
+
+void replay_recorder_begin(ReplayRecorder& recorder, World& world);
+
+// Call right before each world_step with what it's about to be stepped with
+void replay_recorder_tick(ReplayRecorder& recorder, World& world, WorldInput input);
+
+// Writes the header and inputs out, returns false if the file couldn't be written
+bool replay_recorder_save(ReplayRecorder& recorder, World& world, const char* path);
+
+bool replay_player_load(ReplayPlayer& player, const char* path);
+
+// Sets up the world and input for the next tick, returns false once the replay has ended or when
+// its inputs turn out to be truncated or corrupt, player.tick is short of header.numTicks then
+bool replay_player_tick(ReplayPlayer& player, World& world, WorldInput& input);
+
+#endif
@@ -0,0 +1,183 @@
+// Round trips replays through a file: left and right moves have to stay one byte varints, a
+// recorded session has to play back the same inputs and final hash, and a truncated file has to be
+// caught rather than played out with stale input. Exits non zero on any failure.
+
+#include "SDL.h"
+
+#include "simulation.h"
+#include "replay.h"
+
+#include <stdio.h>
+#include <vector>
+
+const char* REPLAY_TEST_PATH = "replay_test.replay";
+const int REPLAY_TEST_TICKS = 600;
+
+static int gNumFailed = 0;
+
+static void check(bool condition, const char* what)
+{
+    if(!condition)
+    {
+        printf("FAILED: %s\n", what);
+        ++gNumFailed;
+    }
+}
+
+// Tick i of the scripted session
+static void replay_test_input(int tick, WorldInput& input, int& width, int& height)
+{
+    input.paddleVelX = ((tick / 40) % 3 - 1) * MOVE_VEL;
+    width = tick < REPLAY_TEST_TICKS / 2 ? 640 : 800;
+    height = 480;
+}
+
+static bool write_file(const char* path, const std::vector<Uint8>& bytes)
+{
+    FILE* file = fopen(path, "wb");
+    if(file == NULL) return false;
+    
+    bool success = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    if(fclose(file) != 0) success = false;
+    
+    return success;
+}
+
+static bool read_file(const char* path, std::vector<Uint8>& bytes)
+{
+    FILE* file = fopen(path, "rb");
+    if(file == NULL) return false;
+    
+    Uint8 buffer[4096];
+    size_t numRead;
+    while((numRead = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        bytes.insert(bytes.end(), buffer, buffer + numRead);
+    }
+    
+    fclose(file);
+    
+    return true;
+}
+
+// A change to velX on the first tick is a record of three one byte varints: ticks since the last
+// record, what changed and the zigzagged velocity
+static void test_encoded_size(int velX)
+{
+    World world;
+    world_create(world, 640, 480);
+    
+    ReplayRecorder recorder;
+    replay_recorder_begin(recorder, world);
+    
+    WorldInput input = {velX};
+    replay_recorder_tick(recorder, world, input);
+    
+    char what[64];
+    SDL_snprintf(what, sizeof(what), "paddleVelX %d is a 3 byte record, got %d", velX, (int)recorder.inputs.size());
+    check(recorder.inputs.size() == 3, what);
+    
+    world_destroy(world);
+}
+
+static void test_round_trip()
+{
+    World world;
+    world_create(world, 640, 480);
+    
+    ReplayRecorder recorder;
+    replay_recorder_begin(recorder, world);
+    
+    for(int tick = 0; tick < REPLAY_TEST_TICKS; ++tick)
+    {
+        WorldInput input;
+        replay_test_input(tick, input, world.width, world.height);
+        
+        replay_recorder_tick(recorder, world, input);
+        world_step(world, input);
+    }
+    
+    check(replay_recorder_save(recorder, world, REPLAY_TEST_PATH), "replay saves");
+    Uint64 finalHash = world_hash(world);
+    world_destroy(world);
+    
+    ReplayPlayer player;
+    check(replay_player_load(player, REPLAY_TEST_PATH), "replay loads");
+    
+    world_create(world, player.header.width, player.header.height);
+    
+    bool inputsMatch = true;
+    WorldInput input;
+    while(replay_player_tick(player, world, input))
+    {
+        WorldInput expected;
+        int width, height;
+        replay_test_input((int)world.tick, expected, width, height);
+        if(input.paddleVelX != expected.paddleVelX || world.width != width || world.height != height) inputsMatch = false;
+        
+        world_step(world, input);
+    }
+    
+    check(player.tick == REPLAY_TEST_TICKS, "every tick plays back");
+    check(inputsMatch, "played back inputs match the recorded ones");
+    check(world_hash(world) == finalHash && finalHash == player.header.finalHash, "final hash matches");
+    
+    world_destroy(world);
+}
+
+// A file cut part way through its last record has to stop short of the recorded tick count. Records
+// are at least 3 bytes, so cutting 1 or 2 always lands inside one. A cut on a record boundary
+// leaves a shorter but well formed replay, nothing in the format can tell.
+static void test_truncated()
+{
+    std::vector<Uint8> bytes;
+    check(read_file(REPLAY_TEST_PATH, bytes), "replay reads back");
+    
+    int numPlayedOut = 0;
+    for(size_t size = bytes.size() - 1; size >= bytes.size() - 2; --size)
+    {
+        std::vector<Uint8> truncated(bytes.begin(), bytes.begin() + size);
+        if(!write_file(REPLAY_TEST_PATH, truncated)) break;
+        
+        ReplayPlayer player;
+        if(!replay_player_load(player, REPLAY_TEST_PATH)) continue;
+        
+        World world;
+        world_create(world, player.header.width, player.header.height);
+        
+        WorldInput input;
+        while(replay_player_tick(player, world, input))
+        {
+            world_step(world, input);
+        }
+        
+        if(player.tick == player.header.numTicks) ++numPlayedOut;
+        
+        world_destroy(world);
+    }
+    
+    check(numPlayedOut == 0, "truncated replays are caught");
+    
+    remove(REPLAY_TEST_PATH);
+}
+
+#undef main
+int main(int argc, char *argv[])
+{
+    test_encoded_size(-1);
+    test_encoded_size(1);
+    test_encoded_size(-MOVE_VEL);
+    test_encoded_size(MOVE_VEL);
+    
+    test_round_trip();
+    test_truncated();
+    
+    if(gNumFailed)
+    {
+        printf("%d replay checks failed\n", gNumFailed);
+        return 1;
+    }
+    
+    printf("replay ok\n");
+    return 0;
+}
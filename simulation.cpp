@@ -0,0 +1,901 @@
+#include "simulation.h"
+#include "profile.h"
+
+#include <stdlib.h>
+#include <math.h>
+
+int clamp(int current, int min, int max)
+{
+    if(current > max) return max;
+    if(current < min) return min;
+    
+    return current;
+}
+
+// NOTE(chris) source: https://gamedev.stackexchange.com/questions/29786/a-simple-2d-rectangle-collision-algorithm-that-also-determines-which-sides-that/29796#29796
+LRectangleCollision check_collision(SDL_Rect a, SDL_Rect b)
+{
+    int width = (a.w + b.w) / 2;
+    int height = (a.h + b.h) / 2;
+    
+    int aCenterX = a.x + (a.w / 2);
+    int aCenterY = a.y + (a.h / 2);
+    
+    int bCenterX = b.x + (b.w / 2);
+    int bCenterY = b.y + (b.h / 2);
+    
+    int deltaX = aCenterX - bCenterX;
+    int deltaY = aCenterY - bCenterY;
+    
+    if(abs(deltaX) <= width && abs(deltaY) <= height)
+    {
+        // A collision has occurred, solve for which side
+        int crossWidth = width * deltaY;
+        int crossHeight = height * deltaX;
+        
+        if(crossWidth > crossHeight)
+        {
+            if(crossWidth > -crossHeight)
+            {
+                return COLLISION_TOP;
+            }
+            else
+            {
+                return COLLISION_LEFT;
+            }
+        }
+        else
+        {
+            if(crossWidth > -crossHeight)
+            {
+                return COLLISION_RIGHT;
+            }
+            else
+            {
+                return COLLISION_BOTTOM;
+            }
+        }
+        
+        return COLLISION_TOP;
+    }
+    
+    return COLLISION_NONE;
+}
+
+bool check_window_collision_x(World& world, Transform transform)
+{
+    return (transform.posX < 0 || transform.posX + transform.collider.w > world.width);
+}
+
+bool check_window_collision_y(World& world, Transform transform)
+{
+    return (transform.posY < 0 || transform.posY + transform.collider.h > world.height);
+}
+
+void transform_move(Transform& transform)
+{
+    transform.posX += transform.velX;
+    transform.collider.x = transform.posX;
+    
+    transform.posY += transform.velY;
+    transform.collider.y = transform.posY;
+}
+
+void transform_keep_on_screen(World& world, Transform& transform)
+{
+    if(check_window_collision_x(world, transform))
+    {
+        transform.posX -= transform.velX;
+        transform.collider.x = transform.posX;
+    }
+    
+    if(check_window_collision_y(world, transform))
+    {
+        transform.posY -= transform.velY;
+        transform.collider.y = transform.posY;
+    }
+}
+
+SDL_Rect transform_interpolate(Transform& previous, Transform& current, float alpha)
+{
+    SDL_Rect result = current.collider;
+    result.x = previous.collider.x + (int)floorf((current.collider.x - previous.collider.x) * alpha + 0.5f);
+    result.y = previous.collider.y + (int)floorf((current.collider.y - previous.collider.y) * alpha + 0.5f);
+    
+    return result;
+}
+
+void ball_pool_destroy(BallPool& pool)
+{
+    delete[] pool.posX;
+    delete[] pool.posY;
+    delete[] pool.prevPosX;
+    delete[] pool.prevPosY;
+    delete[] pool.velX;
+    delete[] pool.velY;
+    delete[] pool.w;
+    delete[] pool.h;
+    
+    pool = BallPool();
+}
+
+static void ball_pool_grow_array(int*& array, int numBalls, int capacity)
+{
+    int* grown = new int[capacity];
+    for(int i = 0; i < numBalls; ++i)
+    {
+        grown[i] = array[i];
+    }
+    
+    delete[] array;
+    array = grown;
+}
+
+void ball_pool_reserve(BallPool& pool, int capacity)
+{
+    if(capacity <= pool.capacity) return;
+    
+    ball_pool_grow_array(pool.posX, pool.numBalls, capacity);
+    ball_pool_grow_array(pool.posY, pool.numBalls, capacity);
+    ball_pool_grow_array(pool.prevPosX, pool.numBalls, capacity);
+    ball_pool_grow_array(pool.prevPosY, pool.numBalls, capacity);
+    ball_pool_grow_array(pool.velX, pool.numBalls, capacity);
+    ball_pool_grow_array(pool.velY, pool.numBalls, capacity);
+    ball_pool_grow_array(pool.w, pool.numBalls, capacity);
+    ball_pool_grow_array(pool.h, pool.numBalls, capacity);
+    
+    pool.capacity = capacity;
+}
+
+int ball_pool_spawn(BallPool& pool, int posX, int posY, int velX, int velY, int width, int height)
+{
+    if(pool.numBalls == pool.capacity)
+    {
+        ball_pool_reserve(pool, pool.capacity ? pool.capacity * 2 : 16);
+    }
+    
+    int index = pool.numBalls++;
+    pool.posX[index] = posX;
+    pool.posY[index] = posY;
+    pool.prevPosX[index] = posX;
+    pool.prevPosY[index] = posY;
+    pool.velX[index] = velX;
+    pool.velY[index] = velY;
+    pool.w[index] = width;
+    pool.h[index] = height;
+    
+    return index;
+}
+
+Transform ball_pool_get(BallPool& pool, int index)
+{
+    Transform ball;
+    ball.posX = pool.posX[index];
+    ball.posY = pool.posY[index];
+    ball.velX = pool.velX[index];
+    ball.velY = pool.velY[index];
+    ball.collider.x = ball.posX;
+    ball.collider.y = ball.posY;
+    ball.collider.w = pool.w[index];
+    ball.collider.h = pool.h[index];
+    
+    return ball;
+}
+
+void ball_pool_set(BallPool& pool, int index, Transform& ball)
+{
+    pool.posX[index] = ball.posX;
+    pool.posY[index] = ball.posY;
+    pool.velX[index] = ball.velX;
+    pool.velY[index] = ball.velY;
+}
+
+SDL_Rect ball_pool_interpolate(BallPool& pool, int index, float alpha)
+{
+    SDL_Rect result;
+    result.x = pool.prevPosX[index] + (int)floorf((pool.posX[index] - pool.prevPosX[index]) * alpha + 0.5f);
+    result.y = pool.prevPosY[index] + (int)floorf((pool.posY[index] - pool.prevPosY[index]) * alpha + 0.5f);
+    result.w = pool.w[index];
+    result.h = pool.h[index];
+    
+    return result;
+}
+
+void block_store_destroy(BlockStore& store)
+{
+    Arena* arena = store.arena;
+    if(!store.borrowed)
+    {
+        arena_delete_array(arena, store.x);
+        arena_delete_array(arena, store.y);
+        arena_delete_array(arena, store.w);
+        arena_delete_array(arena, store.h);
+        arena_delete_array(arena, store.color);
+    }
+    
+    arena_delete_array(arena, store.hitPoints);
+    arena_delete_array(arena, store.active);
+    
+    store = BlockStore();
+    store.arena = arena;
+}
+
+void block_store_reserve(BlockStore& store, int capacity)
+{
+    capacity = (capacity + 63) & ~63;
+    if(capacity <= store.capacity)
+    {
+        if(!store.borrowed) return;
+        capacity = store.capacity;
+    }
+    
+    int numWords = capacity / 64;
+    
+    // Zeroed so the broad-phase can always read whole words of blocks
+    Arena* arena = store.arena;
+    int* x = arena_new_array<int>(arena, capacity);
+    int* y = arena_new_array<int>(arena, capacity);
+    int* w = arena_new_array<int>(arena, capacity);
+    int* h = arena_new_array<int>(arena, capacity);
+    Uint8* color = arena_new_array<Uint8>(arena, capacity);
+    Uint8* hitPoints = arena_new_array<Uint8>(arena, capacity);
+    Uint64* active = arena_new_array<Uint64>(arena, numWords);
+    
+    for(int i = 0; i < store.numBlocks; ++i)
+    {
+        x[i] = store.x[i];
+        y[i] = store.y[i];
+        w[i] = store.w[i];
+        h[i] = store.h[i];
+        color[i] = store.color[i];
+        hitPoints[i] = store.hitPoints[i];
+    }
+    
+    for(int i = 0; i < store.capacity / 64; ++i)
+    {
+        active[i] = store.active[i];
+    }
+    
+    int numBlocks = store.numBlocks;
+    block_store_destroy(store);
+    
+    store.x = x;
+    store.y = y;
+    store.w = w;
+    store.h = h;
+    store.color = color;
+    store.hitPoints = hitPoints;
+    store.active = active;
+    store.numBlocks = numBlocks;
+    store.capacity = capacity;
+}
+
+int block_store_add(BlockStore& store, SDL_Rect collider, int color, int hitPoints)
+{
+    if(store.numBlocks == store.capacity)
+    {
+        block_store_reserve(store, store.capacity ? store.capacity * 2 : 64);
+    }
+    else if(store.borrowed)
+    {
+        block_store_reserve(store, store.capacity);
+    }
+    
+    int index = store.numBlocks++;
+    store.x[index] = collider.x;
+    store.y[index] = collider.y;
+    store.w[index] = collider.w;
+    store.h[index] = collider.h;
+    store.color[index] = (Uint8)color;
+    store.hitPoints[index] = (Uint8)hitPoints;
+    store.active[index >> 6] |= (Uint64)1 << (index & 63);
+    
+    return index;
+}
+
+BlockRow block_row_create(World& world, int yPos, int width, int height, int spacing, int color)
+{
+    BlockRow row;
+    row.first = world.blocks.numBlocks;
+    row.numBlocks = world.width / width;
+    
+    // The grid cell is the smallest block seen, so a ball only ever overlaps a handful of cells
+    if(world.grid.cellWidth == 0 || width < world.grid.cellWidth) world.grid.cellWidth = width;
+    if(world.grid.cellHeight == 0 || height < world.grid.cellHeight) world.grid.cellHeight = height;
+    
+    for(int i = 0; i < row.numBlocks; ++i)
+    {
+        SDL_Rect collider;
+        collider.x = (i * width) + (i * spacing);
+        collider.y = yPos;
+        
+        collider.w = width;
+        collider.h = height;
+        
+        block_store_add(world.blocks, collider, color, 1);
+    }
+    
+    return row;
+}
+
+void block_grid_build(World& world)
+{
+    BlockGrid& grid = world.grid;
+    BlockStore& store = world.blocks;
+    
+    grid.numCellsX = 0;
+    grid.numCellsY = 0;
+    grid.cellStart = NULL;
+    grid.cellBlocks = NULL;
+    
+    if(grid.cellWidth <= 0 || grid.cellHeight <= 0) return;
+    
+    int maxX = 0;
+    int maxY = 0;
+    for(int i = 0; i < store.numBlocks; ++i)
+    {
+        if(store.x[i] + store.w[i] > maxX) maxX = store.x[i] + store.w[i];
+        if(store.y[i] + store.h[i] > maxY) maxY = store.y[i] + store.h[i];
+    }
+    
+    grid.numCellsX = maxX / grid.cellWidth + 1;
+    grid.numCellsY = maxY / grid.cellHeight + 1;
+    int numCells = grid.numCellsX * grid.numCellsY;
+    
+    // Count the blocks in each cell, then prefix sum into start offsets
+    grid.cellStart = arena_new_array<int>(grid.arena, numCells + 1);
+    
+    for(int pass = 0; pass < 2; ++pass)
+    {
+        int* cellFill = NULL;
+        if(pass == 1)
+        {
+            for(int cell = 0; cell < numCells; ++cell)
+            {
+                grid.cellStart[cell + 1] += grid.cellStart[cell];
+            }
+            
+            grid.cellBlocks = arena_new_array<int>(grid.arena, grid.cellStart[numCells]);
+            
+            cellFill = arena_new_array<int>(grid.arena, numCells);
+            for(int cell = 0; cell < numCells; ++cell)
+            {
+                cellFill[cell] = grid.cellStart[cell];
+            }
+        }
+        
+        for(int i = 0; i < store.numBlocks; ++i)
+        {
+            int minCellX = store.x[i] / grid.cellWidth;
+            int minCellY = store.y[i] / grid.cellHeight;
+            int maxCellX = (store.x[i] + store.w[i] - 1) / grid.cellWidth;
+            int maxCellY = (store.y[i] + store.h[i] - 1) / grid.cellHeight;
+            
+            for(int cellY = minCellY; cellY <= maxCellY; ++cellY)
+            {
+                for(int cellX = minCellX; cellX <= maxCellX; ++cellX)
+                {
+                    int cell = cellY * grid.numCellsX + cellX;
+                    if(pass == 0)
+                    {
+                        ++grid.cellStart[cell + 1];
+                    }
+                    else
+                    {
+                        grid.cellBlocks[cellFill[cell]++] = i;
+                    }
+                }
+            }
+        }
+        
+        arena_delete_array(grid.arena, cellFill);
+    }
+}
+
+void block_grid_destroy(BlockGrid& grid)
+{
+    arena_delete_array(grid.arena, grid.cellStart);
+    arena_delete_array(grid.arena, grid.cellBlocks);
+    grid.cellStart = NULL;
+    grid.cellBlocks = NULL;
+    grid.numCellsX = 0;
+    grid.numCellsY = 0;
+}
+
+void block_grid_allocate(BlockGrid& grid, int numCells, int numCellBlocks)
+{
+    block_grid_destroy(grid);
+    grid.cellStart = arena_new_array<int>(grid.arena, numCells + 1);
+    grid.cellBlocks = arena_new_array<int>(grid.arena, numCellBlocks);
+}
+
+int block_grid_query(World& world, SDL_Rect area, int* candidates, int maxCandidates)
+{
+    BlockGrid& grid = world.grid;
+    BlockStore& store = world.blocks;
+    if(grid.cellStart == NULL) return 0;
+    
+    int minCellX = area.x / grid.cellWidth;
+    int minCellY = area.y / grid.cellHeight;
+    int maxCellX = (area.x + area.w) / grid.cellWidth;
+    int maxCellY = (area.y + area.h) / grid.cellHeight;
+    
+    if(area.x + area.w < 0 || area.y + area.h < 0 || minCellX >= grid.numCellsX || minCellY >= grid.numCellsY) return 0;
+    
+    minCellX = clamp(minCellX, 0, grid.numCellsX - 1);
+    minCellY = clamp(minCellY, 0, grid.numCellsY - 1);
+    maxCellX = clamp(maxCellX, 0, grid.numCellsX - 1);
+    maxCellY = clamp(maxCellY, 0, grid.numCellsY - 1);
+    
+    int numCandidates = 0;
+    
+    for(int cellY = minCellY; cellY <= maxCellY; ++cellY)
+    {
+        for(int cellX = minCellX; cellX <= maxCellX; ++cellX)
+        {
+            int cell = cellY * grid.numCellsX + cellX;
+            for(int i = grid.cellStart[cell]; i < grid.cellStart[cell + 1]; ++i)
+            {
+                int index = grid.cellBlocks[i];
+                if(!block_is_active(store, index)) continue;
+                
+                if(numCandidates == maxCandidates) return -1;
+                
+                candidates[numCandidates++] = index;
+            }
+        }
+    }
+    
+    for(int i = 1; i < numCandidates; ++i)
+    {
+        int index = candidates[i];
+        int j = i - 1;
+        while(j >= 0 && candidates[j] > index)
+        {
+            candidates[j + 1] = candidates[j];
+            --j;
+        }
+        candidates[j + 1] = index;
+    }
+    
+    // A block spanning several cells shows up once per cell
+    int numUnique = 0;
+    for(int i = 0; i < numCandidates; ++i)
+    {
+        if(numUnique == 0 || candidates[numUnique - 1] != candidates[i])
+        {
+            candidates[numUnique++] = candidates[i];
+        }
+    }
+    
+    return numUnique;
+}
+
+static int round_to_int(float value)
+{
+    return (int)floorf(value + 0.5f);
+}
+
+static bool rects_overlap(SDL_Rect a, SDL_Rect b)
+{
+    return a.x < b.x + b.w && a.x + a.w > b.x && a.y < b.y + b.h && a.y + a.h > b.y;
+}
+
+// Swept AABB, see https://www.gamedev.net/articles/programming/general-and-gameplay-programming/swept-aabb-collision-detection-and-response-r3084/
+// Finds the time in [0, 1] at which moving, travelling (dx, dy), first touches target and the normal of
+// the face it touches. Rects that already overlap don't count, the caller deals with those.
+static bool sweep_rect(SDL_Rect moving, float dx, float dy, SDL_Rect target, float& time, int& normalX, int& normalY)
+{
+    float entryX, exitX;
+    if(dx > 0.0f)
+    {
+        entryX = (target.x - (moving.x + moving.w)) / dx;
+        exitX = (target.x + target.w - moving.x) / dx;
+    }
+    else if(dx < 0.0f)
+    {
+        entryX = (target.x + target.w - moving.x) / dx;
+        exitX = (target.x - (moving.x + moving.w)) / dx;
+    }
+    else
+    {
+        if(moving.x + moving.w <= target.x || moving.x >= target.x + target.w) return false;
+        entryX = -INFINITY;
+        exitX = INFINITY;
+    }
+    
+    float entryY, exitY;
+    if(dy > 0.0f)
+    {
+        entryY = (target.y - (moving.y + moving.h)) / dy;
+        exitY = (target.y + target.h - moving.y) / dy;
+    }
+    else if(dy < 0.0f)
+    {
+        entryY = (target.y + target.h - moving.y) / dy;
+        exitY = (target.y - (moving.y + moving.h)) / dy;
+    }
+    else
+    {
+        if(moving.y + moving.h <= target.y || moving.y >= target.y + target.h) return false;
+        entryY = -INFINITY;
+        exitY = INFINITY;
+    }
+    
+    float entry = SDL_max(entryX, entryY);
+    float exit = SDL_min(exitX, exitY);
+    
+    if(entry >= exit || entry < 0.0f || entry > 1.0f) return false;
+    
+    time = entry;
+    normalX = 0;
+    normalY = 0;
+    if(entryX > entryY)
+    {
+        normalX = (dx > 0.0f) ? -1 : 1;
+    }
+    else
+    {
+        normalY = (dy > 0.0f) ? -1 : 1;
+    }
+    
+    return true;
+}
+
+enum SweepTarget
+{
+    SWEEP_NONE = 0,
+    SWEEP_WALL = 1,
+    SWEEP_BLOCK = 2,
+    SWEEP_PADDLE = 3
+};
+
+struct SweepHit
+{
+    SweepTarget target;
+    float time;
+    int normalX, normalY;
+    int blockIndex;
+};
+
+static void sweep_hit_offer(SweepHit& hit, SweepTarget target, float time, int normalX, int normalY, int blockIndex)
+{
+    // Strictly earlier only, so on a tie the first thing offered wins
+    if(hit.target == SWEEP_NONE || time < hit.time)
+    {
+        hit.target = target;
+        hit.time = time;
+        hit.normalX = normalX;
+        hit.normalY = normalY;
+        hit.blockIndex = blockIndex;
+    }
+}
+
+static void sweep_walls(World& world, Transform& ball, float dx, float dy, SweepHit& hit)
+{
+    // The bottom is left open, that's where the ball is lost
+    if(dx < 0.0f)
+    {
+        float time = SDL_max(0.0f, -ball.posX / dx);
+        if(time <= 1.0f) sweep_hit_offer(hit, SWEEP_WALL, time, 1, 0, -1);
+    }
+    else if(dx > 0.0f)
+    {
+        float time = SDL_max(0.0f, (world.width - (ball.posX + ball.collider.w)) / dx);
+        if(time <= 1.0f) sweep_hit_offer(hit, SWEEP_WALL, time, -1, 0, -1);
+    }
+    
+    if(dy < 0.0f)
+    {
+        float time = SDL_max(0.0f, -ball.posY / dy);
+        if(time <= 1.0f) sweep_hit_offer(hit, SWEEP_WALL, time, 0, 1, -1);
+    }
+}
+
+static void sweep_block(World& world, Transform& ball, float dx, float dy, int index, SweepHit& hit)
+{
+    SDL_Rect collider = block_collider(world.blocks, index);
+    
+    if(rects_overlap(ball.collider, collider))
+    {
+        // Already inside (the window shrank, or we ran out of bounces last tick), get out the way
+        // the discrete test would have
+        LRectangleCollision result = check_collision(ball.collider, collider);
+        if(result == COLLISION_LEFT || result == COLLISION_RIGHT)
+        {
+            sweep_hit_offer(hit, SWEEP_BLOCK, 0.0f, result == COLLISION_LEFT ? -1 : 1, 0, index);
+        }
+        else
+        {
+            sweep_hit_offer(hit, SWEEP_BLOCK, 0.0f, 0, result == COLLISION_TOP ? 1 : -1, index);
+        }
+        return;
+    }
+    
+    float time;
+    int normalX, normalY;
+    if(sweep_rect(ball.collider, dx, dy, collider, time, normalX, normalY))
+    {
+        sweep_hit_offer(hit, SWEEP_BLOCK, time, normalX, normalY, index);
+    }
+}
+
+static void sweep_blocks(World& world, Transform& ball, float dx, float dy, SweepHit& hit)
+{
+    BlockStore& store = world.blocks;
+    
+    // Everything the ball could touch this tick
+    SDL_Rect area;
+    area.x = ball.posX + SDL_min(0, (int)floorf(dx)) - 1;
+    area.y = ball.posY + SDL_min(0, (int)floorf(dy)) - 1;
+    area.w = ball.collider.w + (int)ceilf(fabsf(dx)) + 2;
+    area.h = ball.collider.h + (int)ceilf(fabsf(dy)) + 2;
+    
+    int candidates[BLOCK_GRID_MAX_CANDIDATES];
+    int numCandidates = block_grid_query(world, area, candidates, BLOCK_GRID_MAX_CANDIDATES);
+    if(numCandidates >= 0)
+    {
+        // Only a few blocks, masking them with block_overlap_word first measured no faster
+        for(int i = 0; i < numCandidates; ++i)
+        {
+            sweep_block(world, ball, dx, dy, candidates[i], hit);
+        }
+    }
+    else
+    {
+        // Too many blocks in the way for the grid query, fall back to the broad-phase over the whole store
+        int numWords = (store.numBlocks + 63) / 64;
+        for(int word = 0; word < numWords; ++word)
+        {
+            Uint64 bits = block_active_bits(store, word);
+            if(bits == 0) continue;
+            
+            bits &= block_overlap_word(store, word, area);
+            while(bits)
+            {
+                int index = word * 64 + bit_scan_forward(bits);
+                bits &= bits - 1;
+                
+                sweep_block(world, ball, dx, dy, index, hit);
+            }
+        }
+    }
+}
+
+static void sweep_paddle(World& world, Transform& ball, float dx, float dy, SweepHit& hit)
+{
+    Transform& paddle = world.paddle;
+    
+    if(rects_overlap(ball.collider, paddle.collider))
+    {
+        // The paddle moved into the ball, only bounce if that's not already heading away
+        if(ball.velY > 0)
+        {
+            sweep_hit_offer(hit, SWEEP_PADDLE, 0.0f, 0, -1, -1);
+        }
+        return;
+    }
+    
+    float time;
+    int normalX, normalY;
+    if(sweep_rect(ball.collider, dx, dy, paddle.collider, time, normalX, normalY))
+    {
+        sweep_hit_offer(hit, SWEEP_PADDLE, time, normalX, normalY, -1);
+    }
+}
+
+void ball_move_swept(World& world, Transform& ball)
+{
+    Transform& paddle = world.paddle;
+    float remaining = 1.0f;
+    
+    for(int bounce = 0; bounce < BALL_MAX_BOUNCES_PER_TICK; ++bounce)
+    {
+        float dx = ball.velX * remaining;
+        float dy = ball.velY * remaining;
+        
+        SweepHit hit = {};
+        sweep_walls(world, ball, dx, dy, hit);
+        sweep_blocks(world, ball, dx, dy, hit);
+        sweep_paddle(world, ball, dx, dy, hit);
+        
+        if(hit.target == SWEEP_NONE)
+        {
+            ball.posX += round_to_int(dx);
+            ball.posY += round_to_int(dy);
+            ball.collider.x = ball.posX;
+            ball.collider.y = ball.posY;
+            return;
+        }
+        
+        // Move up to the point of contact and spend the rest of the tick going the new way
+        ball.posX += round_to_int(dx * hit.time);
+        ball.posY += round_to_int(dy * hit.time);
+        ball.collider.x = ball.posX;
+        ball.collider.y = ball.posY;
+        remaining -= remaining * hit.time;
+        
+        // Another ball killed it first this tick, carry on as if it was never there
+        if(hit.target == SWEEP_BLOCK && !block_hit(world.blocks, hit.blockIndex)) continue;
+        
+        if(hit.target == SWEEP_PADDLE && hit.normalY != 0)
+        {
+            // Add velocity based on which side of the paddle we hit
+            if(paddle.collider.x + paddle.collider.w / 2 > ball.collider.x + ball.collider.w / 2)
+            {
+                ball.velX = -abs(ball.velX + paddle.velX);
+            }
+            else
+            {
+                ball.velX = abs(ball.velX + paddle.velX);
+            }
+            
+            ball.velY = -ball.velY - 1; // add a little bit of vertical vel each paddle collision
+        }
+        else
+        {
+            if(hit.normalX != 0) ball.velX = -ball.velX;
+            if(hit.normalY != 0) ball.velY = -ball.velY;
+        }
+    }
+    
+    // Out of bounces, the ball waits at the last contact point for the rest of the tick
+}
+
+void world_create_empty(World& world, int width, int height, Arena* levelArena)
+{
+    world.width = width;
+    world.height = height;
+    world.tick = 0;
+    
+    world.blocks = BlockStore();
+    world.blocks.arena = levelArena;
+    world.numRows = 0;
+    world.numColors = 0;
+    world.grid = BlockGrid();
+    world.grid.arena = levelArena;
+    
+    Transform& paddle = world.paddle;
+    paddle.collider.w = 100;
+    paddle.collider.h = 40;
+    paddle.posX = world.width / 2;
+    paddle.posY = world.height - 30;
+    paddle.velX = 0;
+    paddle.velY = 0;
+    paddle.collider.x = paddle.posX;
+    paddle.collider.y = paddle.posY;
+    
+    world.balls = BallPool();
+    ball_pool_spawn(world.balls, world.width / 4, world.height / 2, BALL_VEL, -BALL_VEL, 25, 25);
+}
+
+void world_create(World& world, int width, int height, Arena* levelArena)
+{
+    world_create_empty(world, width, height, levelArena);
+    
+    SDL_Color rowColors[WORLD_MAX_ROWS] = {{0xFF, 0x00, 0x00, 0xFF}, {0x00, 0xFF, 0x00, 0xFF}, {0x00, 0x00, 0xFF, 0xFF}};
+    for(int i = 0; i < WORLD_MAX_ROWS; ++i)
+    {
+        world.colors[i] = rowColors[i];
+    }
+    world.numColors = WORLD_MAX_ROWS;
+    
+    int yPos = 0;
+    world.rows[0] = block_row_create(world, yPos, 200, 20, 3, 0);
+    yPos += 20;
+    world.rows[1] = block_row_create(world, yPos, 100, 40, 3, 1);
+    yPos += 40;
+    world.rows[2] = block_row_create(world, yPos, 50, 20, 3, 2);
+    world.numRows = 3;
+    
+    block_grid_build(world);
+}
+
+void world_destroy(World& world)
+{
+    ball_pool_destroy(world.balls);
+    
+    block_store_destroy(world.blocks);
+    world.numRows = 0;
+    
+    block_grid_destroy(world.grid);
+}
+
+void world_step_paddle(World& world, WorldInput input)
+{
+    Transform& paddle = world.paddle;
+    
+    paddle.velX = input.paddleVelX;
+    
+    transform_move(paddle);
+    transform_keep_on_screen(world, paddle);
+}
+
+void world_step_balls(World& world, int first, int end)
+{
+    BallPool& balls = world.balls;
+    
+    for(int i = first; i < end; ++i)
+    {
+        balls.prevPosX[i] = balls.posX[i];
+        balls.prevPosY[i] = balls.posY[i];
+        
+        Transform ball = ball_pool_get(balls, i);
+        
+        // TODO(chris) if(ball.posY + ball.collider.h > world.height)
+        ball_move_swept(world, ball);
+        
+        ball.velX = clamp(ball.velX, -BALL_MAX_VEL, BALL_MAX_VEL);
+        ball.velY = clamp(ball.velY, -BALL_MAX_VEL, BALL_MAX_VEL);
+        
+        ball_pool_set(balls, i, ball);
+    }
+}
+
+void world_step(World& world, WorldInput input)
+{
+    {
+        PROFILE_SCOPE(PROFILE_PADDLE);
+        world_step_paddle(world, input);
+    }
+    
+    {
+        PROFILE_SCOPE(PROFILE_BALLS);
+        world_step_balls(world, 0, world.balls.numBalls);
+    }
+    
+    ++world.tick;
+}
+
+static void world_step_balls_job(void* data, int first, int end)
+{
+    world_step_balls(*(World*)data, first, end);
+}
+
+void world_step_parallel(World& world, WorldInput input, JobSystem& jobs)
+{
+    {
+        PROFILE_SCOPE(PROFILE_PADDLE);
+        world_step_paddle(world, input);
+    }
+    
+    {
+        PROFILE_SCOPE(PROFILE_BALLS);
+        job_parallel_for(jobs, world.balls.numBalls, WORLD_BALLS_PER_JOB, world_step_balls_job, &world);
+    }
+    
+    ++world.tick;
+}
+
+static void hash_bytes(Uint64& hash, const void* data, size_t size)
+{
+    const Uint8* bytes = (const Uint8*)data;
+    for(size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+Uint64 world_hash(World& world)
+{
+    Uint64 hash = 14695981039346656037ull;
+    
+    hash_bytes(hash, &world.tick, sizeof(world.tick));
+    hash_bytes(hash, &world.paddle.posX, sizeof(world.paddle.posX));
+    hash_bytes(hash, &world.paddle.posY, sizeof(world.paddle.posY));
+    
+    BallPool& balls = world.balls;
+    hash_bytes(hash, &balls.numBalls, sizeof(balls.numBalls));
+    hash_bytes(hash, balls.posX, balls.numBalls * sizeof(int));
+    hash_bytes(hash, balls.posY, balls.numBalls * sizeof(int));
+    hash_bytes(hash, balls.velX, balls.numBalls * sizeof(int));
+    hash_bytes(hash, balls.velY, balls.numBalls * sizeof(int));
+    
+    BlockStore& blocks = world.blocks;
+    hash_bytes(hash, &blocks.numBlocks, sizeof(blocks.numBlocks));
+    hash_bytes(hash, blocks.active, ((blocks.numBlocks + 63) / 64) * sizeof(Uint64));
+    hash_bytes(hash, blocks.hitPoints, blocks.numBlocks);
+    
+    return hash;
+}
@@ -0,0 +1,299 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+// Headless game simulation. Only SDL types are used here (SDL_Rect), SDL itself never needs to be
+// initialised, so this can be stepped without a window, renderer or font.
+
+#include "SDL_rect.h"
+#include "SDL_pixels.h"
+
+#include "jobs.h"
+#include "arena.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Every block of the level, structure of arrays so the collision and render loops only touch
+// the fields they need. Whether a block is still alive is one bit in active, 64 blocks per word,
+// bits past numBlocks are always 0.
+// When borrowed the rects and colors point into a mapped level file and are never written or freed,
+// only active and hitPoints are the store's own.
+// With an arena every array comes out of it and lives until the arena is reset, destroy frees nothing.
+struct BlockStore
+{
+    int numBlocks;
+    int capacity;
+    bool borrowed;
+    Arena* arena;
+    
+    int* x;
+    int* y;
+    int* w;
+    int* h;
+    Uint8* color; // index into World::colors
+    
+    Uint8* hitPoints;
+    Uint64* active;
+};
+
+// Every ball in play, structure of arrays. prevPosX/prevPosY are where each ball was before the
+// last tick, so the platform layer can interpolate between ticks.
+struct BallPool
+{
+    int numBalls;
+    int capacity;
+    
+    int* posX;
+    int* posY;
+    int* prevPosX;
+    int* prevPosY;
+    int* velX;
+    int* velY;
+    int* w;
+    int* h;
+};
+
+// A contiguous range of blocks in the store
+struct BlockRow
+{
+    int first;
+    int numBlocks;
+};
+
+enum LRectangleCollision
+{
+    COLLISION_NONE = 0,
+    COLLISION_TOP = 1,
+    COLLISION_BOTTOM = 2,
+    COLLISION_LEFT = 3,
+    COLLISION_RIGHT = 4
+};
+
+struct Transform
+{
+    int posX, posY;
+    int velX, velY;
+    
+    SDL_Rect collider;
+};
+
+const int MOVE_VEL = 10;
+const int BALL_VEL = 3;
+const int BALL_MAX_VEL = 8;
+
+// Walls, blocks and the paddle the ball can bounce off within a single tick
+const int BALL_MAX_BOUNCES_PER_TICK = 4;
+
+const int WORLD_BALLS_PER_JOB = 512;
+
+const int WORLD_MAX_ROWS = 3;
+const int WORLD_MAX_COLORS = 8;
+
+// Velocities are in pixels per tick, so this is what sets the game speed, not the render rate
+const int WORLD_TICKS_PER_SECOND = 60;
+
+const int BLOCK_GRID_MAX_CANDIDATES = 256;
+
+// Uniform grid over the block field, each cell lists the blocks overlapping it.
+// Stored CSR style: the blocks of cell i are cellBlocks[cellStart[i]] .. cellBlocks[cellStart[i + 1] - 1]
+struct BlockGrid
+{
+    int cellWidth;
+    int cellHeight;
+    int numCellsX;
+    int numCellsY;
+    
+    int* cellStart;
+    int* cellBlocks;
+    Arena* arena; // same as BlockStore::arena
+};
+
+// Input for a single tick, sampled by the platform layer
+struct WorldInput
+{
+    int paddleVelX;
+};
+
+struct World
+{
+    // Play area, the platform layer keeps this in sync with the window size
+    int width;
+    int height;
+    
+    Transform paddle;
+    BallPool balls;
+    
+    BlockStore blocks;
+    BlockRow rows[WORLD_MAX_ROWS]; // only the built in level has rows
+    int numRows;
+    
+    SDL_Color colors[WORLD_MAX_COLORS];
+    int numColors;
+    
+    BlockGrid grid;
+    
+    Uint64 tick;
+};
+
+int clamp(int current, int min, int max);
+LRectangleCollision check_collision(SDL_Rect a, SDL_Rect b);
+
+bool check_window_collision_x(World& world, Transform transform);
+bool check_window_collision_y(World& world, Transform transform);
+void transform_move(Transform& transform);
+void transform_keep_on_screen(World& world, Transform& transform);
+
+// Collider blended between two ticks, alpha 0 is previous and 1 is current
+SDL_Rect transform_interpolate(Transform& previous, Transform& current, float alpha);
+
+inline int bit_scan_forward(Uint64 bits)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (int)index;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+inline int bit_count(Uint64 bits)
+{
+#ifdef _MSC_VER
+    return (int)__popcnt64(bits);
+#else
+    return __builtin_popcountll(bits);
+#endif
+}
+
+// Balls are updated in parallel and may kill blocks under each other, so the bitset is read with
+// (relaxed) atomic loads and cleared with atomic test-and-clear
+inline Uint64 block_active_bits(BlockStore& store, int word)
+{
+#ifdef _MSC_VER
+    return *(volatile Uint64*)&store.active[word];
+#else
+    return __atomic_load_n(&store.active[word], __ATOMIC_RELAXED);
+#endif
+}
+
+inline bool block_is_active(BlockStore& store, int index)
+{
+    return (block_active_bits(store, index >> 6) >> (index & 63)) & 1;
+}
+
+// Returns false if the block was already dead, i.e. another ball got to it first
+inline bool block_try_kill(BlockStore& store, int index)
+{
+    Uint64 bit = (Uint64)1 << (index & 63);
+#ifdef _MSC_VER
+    Uint64 previous = (Uint64)_InterlockedAnd64((volatile __int64*)&store.active[index >> 6], ~(__int64)bit);
+#else
+    Uint64 previous = __atomic_fetch_and(&store.active[index >> 6], ~bit, __ATOMIC_RELAXED);
+#endif
+    return (previous & bit) != 0;
+}
+
+// Takes a hit point off the block and kills it on the last one. Returns false if the block
+// was already dead, same as block_try_kill, hit points are taken with compare-exchange so two
+// balls can't both take the last one.
+inline bool block_hit(BlockStore& store, int index)
+{
+    Uint8* hitPoints = &store.hitPoints[index];
+    
+#ifdef _MSC_VER
+    char current = *(volatile char*)hitPoints;
+    for(;;)
+    {
+        if(current == 0) return false;
+        
+        char previous = _InterlockedCompareExchange8((volatile char*)hitPoints, current - 1, current);
+        if(previous == current) break;
+        current = previous;
+    }
+#else
+    Uint8 current = __atomic_load_n(hitPoints, __ATOMIC_RELAXED);
+    for(;;)
+    {
+        if(current == 0) return false;
+        
+        if(__atomic_compare_exchange_n(hitPoints, &current, (Uint8)(current - 1), true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+    }
+#endif
+    
+    if(current == 1) return block_try_kill(store, index);
+    
+    return true;
+}
+
+inline SDL_Rect block_collider(BlockStore& store, int index)
+{
+    SDL_Rect collider = {store.x[index], store.y[index], store.w[index], store.h[index]};
+    return collider;
+}
+
+// Broad-phase, bit i is set when block word * 64 + i overlaps query. Tests 4 (SSE2) or 8 (AVX2)
+// blocks per instruction, picked at runtime, with a scalar fallback. Doesn't look at the active bits.
+// Since the grid went in, ball collision only uses this when a query has more than
+// BLOCK_GRID_MAX_CANDIDATES blocks, the dirty rect redraw is its main user.
+Uint64 block_overlap_word(BlockStore& store, int word, SDL_Rect query);
+const char* block_overlap_kernel_name();
+
+void block_store_destroy(BlockStore& store);
+
+// Grows the arrays to hold at least capacity blocks (rounded up to whole words), never shrinks.
+// A borrowed store is always copied into arrays of its own, so it can be written to.
+void block_store_reserve(BlockStore& store, int capacity);
+int block_store_add(BlockStore& store, SDL_Rect collider, int color, int hitPoints);
+
+// Fills the width of the world with blocks, one hit point each
+BlockRow block_row_create(World& world, int yPos, int width, int height, int spacing, int color);
+
+void block_grid_build(World& world);
+void block_grid_destroy(BlockGrid& grid);
+
+// Uninitialised cellStart and cellBlocks arrays for a grid of numCells holding numCellBlocks entries
+void block_grid_allocate(BlockGrid& grid, int numCells, int numCellBlocks);
+
+// Active blocks in the cells overlapping area, sorted by index with no repeats.
+// Returns -1 if there are more than maxCandidates.
+int block_grid_query(World& world, SDL_Rect area, int* candidates, int maxCandidates);
+
+// Moves the ball a whole tick with continuous collision against the walls, blocks and paddle,
+// bouncing at the time of impact so fast balls can't tunnel through thin blocks
+void ball_move_swept(World& world, Transform& ball);
+
+void ball_pool_destroy(BallPool& pool);
+void ball_pool_reserve(BallPool& pool, int capacity);
+int ball_pool_spawn(BallPool& pool, int posX, int posY, int velX, int velY, int width, int height);
+
+// A single ball in and out of the pool, for the per ball collision code
+Transform ball_pool_get(BallPool& pool, int index);
+void ball_pool_set(BallPool& pool, int index, Transform& ball);
+
+SDL_Rect ball_pool_interpolate(BallPool& pool, int index, float alpha);
+
+// The built in level, three rows of blocks sized to fill width. The blocks and grid come out of
+// levelArena when there is one, it's reset on the next level change (after world_destroy).
+void world_create(World& world, int width, int height, Arena* levelArena = NULL);
+
+// Just the paddle and ball, for levels that bring their own blocks
+void world_create_empty(World& world, int width, int height, Arena* levelArena = NULL);
+void world_destroy(World& world);
+
+// Advances the world by exactly one fixed tick
+void world_step(World& world, WorldInput input);
+
+// Same as world_step, with the balls split across the job system. Which ball gets a block two
+// balls reach in the same tick is down to timing, so this isn't deterministic with many balls.
+void world_step_parallel(World& world, WorldInput input, JobSystem& jobs);
+
+// The two halves of a tick, the paddle has to move before any ball does
+void world_step_paddle(World& world, WorldInput input);
+void world_step_balls(World& world, int first, int end);
+
+// FNV-1a over everything a tick can change, two runs that hash the same stayed in lockstep
+Uint64 world_hash(World& world);
+
+#endif
@@ -0,0 +1,220 @@
+#include "snapshot.h"
+
+#include <string.h>
+
+static size_t align8(size_t size)
+{
+    return (size + 7) & ~(size_t)7;
+}
+
+static WorldSnapshotHeader world_snapshot_header(World& world)
+{
+    WorldSnapshotHeader header;
+    memset(&header, 0, sizeof(header)); // no uninitialised padding in the blob
+    
+    header.magic = WORLD_SNAPSHOT_MAGIC;
+    
+    header.width = world.width;
+    header.height = world.height;
+    header.tick = world.tick;
+    header.paddle = world.paddle;
+    
+    for(int i = 0; i < WORLD_MAX_ROWS; ++i)
+    {
+        header.rows[i] = world.rows[i];
+    }
+    header.numRows = world.numRows;
+    
+    for(int i = 0; i < WORLD_MAX_COLORS; ++i)
+    {
+        header.colors[i] = world.colors[i];
+    }
+    header.numColors = world.numColors;
+    
+    header.numBlocks = world.blocks.numBlocks;
+    header.numBlockWords = (world.blocks.numBlocks + 63) / 64;
+    header.numBalls = world.balls.numBalls;
+    
+    BlockGrid& grid = world.grid;
+    header.cellWidth = grid.cellWidth;
+    header.cellHeight = grid.cellHeight;
+    header.numCellsX = grid.numCellsX;
+    header.numCellsY = grid.numCellsY;
+    header.numCellBlocks = grid.cellStart ? grid.cellStart[grid.numCellsX * grid.numCellsY] : 0;
+    
+    return header;
+}
+
+static size_t world_snapshot_size(WorldSnapshotHeader& header)
+{
+    size_t size = align8(sizeof(WorldSnapshotHeader));
+    size += header.numBlockWords * sizeof(Uint64);
+    size += align8(4 * header.numBlockWords * 64 * sizeof(int));
+    size += align8(2 * header.numBlockWords * 64);
+    size += align8(8 * header.numBalls * sizeof(int));
+    
+    if(header.numCellsX * header.numCellsY > 0)
+    {
+        size += align8((header.numCellsX * header.numCellsY + 1) * sizeof(int));
+        size += align8(header.numCellBlocks * sizeof(int));
+    }
+    
+    return size;
+}
+
+size_t world_snapshot_size(World& world)
+{
+    WorldSnapshotHeader header = world_snapshot_header(world);
+    return world_snapshot_size(header);
+}
+
+// Copies size bytes into the blob and moves the cursor past them, rounded up to 8 bytes
+static void put(Uint8*& cursor, const void* data, size_t size)
+{
+    if(size) memcpy(cursor, data, size);
+    cursor += align8(size);
+}
+
+static void get(const Uint8*& cursor, void* data, size_t size)
+{
+    if(size) memcpy(data, cursor, size);
+    cursor += align8(size);
+}
+
+size_t world_snapshot_save(World& world, void* buffer, size_t bufferSize)
+{
+    WorldSnapshotHeader header = world_snapshot_header(world);
+    size_t size = world_snapshot_size(header);
+    if(size > bufferSize) return 0;
+    
+    header.size = (Uint32)size;
+    
+    Uint8* cursor = (Uint8*)buffer;
+    put(cursor, &header, sizeof(header));
+    
+    BlockStore& blocks = world.blocks;
+    size_t blockBytes = header.numBlockWords * 64 * sizeof(int);
+    put(cursor, blocks.active, header.numBlockWords * sizeof(Uint64));
+    memcpy(cursor, blocks.x, blockBytes);
+    memcpy(cursor + blockBytes, blocks.y, blockBytes);
+    memcpy(cursor + blockBytes * 2, blocks.w, blockBytes);
+    memcpy(cursor + blockBytes * 3, blocks.h, blockBytes);
+    cursor += align8(blockBytes * 4);
+    
+    memcpy(cursor, blocks.color, header.numBlockWords * 64);
+    memcpy(cursor + header.numBlockWords * 64, blocks.hitPoints, header.numBlockWords * 64);
+    cursor += align8(header.numBlockWords * 64 * 2);
+    
+    BallPool& balls = world.balls;
+    size_t ballBytes = header.numBalls * sizeof(int);
+    int* ballArrays[] = {balls.posX, balls.posY, balls.prevPosX, balls.prevPosY, balls.velX, balls.velY, balls.w, balls.h};
+    for(int i = 0; i < 8; ++i)
+    {
+        if(ballBytes) memcpy(cursor + ballBytes * i, ballArrays[i], ballBytes);
+    }
+    cursor += align8(ballBytes * 8);
+    
+    int numCells = header.numCellsX * header.numCellsY;
+    if(numCells > 0)
+    {
+        put(cursor, world.grid.cellStart, (numCells + 1) * sizeof(int));
+        put(cursor, world.grid.cellBlocks, header.numCellBlocks * sizeof(int));
+    }
+    
+    return size;
+}
+
+bool world_snapshot_load(World& world, const void* buffer, size_t bufferSize)
+{
+    if(bufferSize < sizeof(WorldSnapshotHeader)) return false;
+    
+    WorldSnapshotHeader header;
+    memcpy(&header, buffer, sizeof(header));
+    if(header.magic != WORLD_SNAPSHOT_MAGIC || header.size > bufferSize || header.size != world_snapshot_size(header))
+    {
+        return false;
+    }
+    
+    const Uint8* cursor = (const Uint8*)buffer + align8(sizeof(header));
+    
+    world.width = header.width;
+    world.height = header.height;
+    world.tick = header.tick;
+    world.paddle = header.paddle;
+    
+    for(int i = 0; i < WORLD_MAX_ROWS; ++i)
+    {
+        world.rows[i] = header.rows[i];
+    }
+    world.numRows = header.numRows;
+    
+    for(int i = 0; i < WORLD_MAX_COLORS; ++i)
+    {
+        world.colors[i] = header.colors[i];
+    }
+    world.numColors = header.numColors;
+    
+    // Whole words are copied, so anything past numBlocks comes back zeroed too
+    BlockStore& blocks = world.blocks;
+    block_store_reserve(blocks, header.numBlockWords * 64);
+    blocks.numBlocks = header.numBlocks;
+    
+    size_t blockBytes = header.numBlockWords * 64 * sizeof(int);
+    get(cursor, blocks.active, header.numBlockWords * sizeof(Uint64));
+    for(int word = header.numBlockWords; word < blocks.capacity / 64; ++word)
+    {
+        blocks.active[word] = 0;
+    }
+    
+    memcpy(blocks.x, cursor, blockBytes);
+    memcpy(blocks.y, cursor + blockBytes, blockBytes);
+    memcpy(blocks.w, cursor + blockBytes * 2, blockBytes);
+    memcpy(blocks.h, cursor + blockBytes * 3, blockBytes);
+    cursor += align8(blockBytes * 4);
+    
+    memcpy(blocks.color, cursor, header.numBlockWords * 64);
+    memcpy(blocks.hitPoints, cursor + header.numBlockWords * 64, header.numBlockWords * 64);
+    cursor += align8(header.numBlockWords * 64 * 2);
+    
+    BallPool& balls = world.balls;
+    ball_pool_reserve(balls, header.numBalls);
+    balls.numBalls = header.numBalls;
+    
+    size_t ballBytes = header.numBalls * sizeof(int);
+    int* ballArrays[] = {balls.posX, balls.posY, balls.prevPosX, balls.prevPosY, balls.velX, balls.velY, balls.w, balls.h};
+    for(int i = 0; i < 8; ++i)
+    {
+        if(ballBytes) memcpy(ballArrays[i], cursor + ballBytes * i, ballBytes);
+    }
+    cursor += align8(ballBytes * 8);
+    
+    // The grid only changes with the level, so it's usually the same shape and can be copied over in place
+    BlockGrid& grid = world.grid;
+    int numCells = header.numCellsX * header.numCellsY;
+    int currentCells = grid.numCellsX * grid.numCellsY;
+    int currentCellBlocks = grid.cellStart ? grid.cellStart[currentCells] : 0;
+    if(grid.cellStart == NULL || numCells != currentCells || header.numCellBlocks != currentCellBlocks)
+    {
+        if(numCells > 0)
+        {
+            block_grid_allocate(grid, numCells, header.numCellBlocks);
+        }
+        else
+        {
+            block_grid_destroy(grid);
+        }
+    }
+    
+    grid.cellWidth = header.cellWidth;
+    grid.cellHeight = header.cellHeight;
+    grid.numCellsX = header.numCellsX;
+    grid.numCellsY = header.numCellsY;
+    
+    if(numCells > 0)
+    {
+        get(cursor, grid.cellStart, (numCells + 1) * sizeof(int));
+        get(cursor, grid.cellBlocks, header.numCellBlocks * sizeof(int));
+    }
+    
+    return true;
+}
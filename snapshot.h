@@ -0,0 +1,61 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "SDL.h"
+
+#include "simulation.h"
+
+// The whole world as one flat block of memory with no pointers in it, so saving and restoring is a
+// handful of memcpys. Layout, everything 8 byte aligned:
+//
+//     WorldSnapshotHeader
+//     Uint64 blocks.active[numBlockWords]
+//     int    blocks.x, y, w, h[numBlockWords * 64]   (whole words, the broad-phase reads past numBlocks)
+//     Uint8  blocks.color, hitPoints[numBlockWords * 64]
+//     int    balls.posX, posY, prevPosX, prevPosY, velX, velY, w, h[numBalls]
+//     int    grid.cellStart[numCells + 1]
+//     int    grid.cellBlocks[numCellBlocks]
+//
+// Snapshots are only meant to be restored by the same build, they're not a file format.
+
+const Uint32 WORLD_SNAPSHOT_MAGIC = 0x50534B42; // "BKSP"
+
+struct WorldSnapshotHeader
+{
+    Uint32 magic;
+    Uint32 size; // of the whole snapshot, header included
+    
+    int width;
+    int height;
+    Uint64 tick;
+    
+    Transform paddle;
+    
+    BlockRow rows[WORLD_MAX_ROWS];
+    int numRows;
+    
+    SDL_Color colors[WORLD_MAX_COLORS];
+    int numColors;
+    
+    int numBlocks;
+    int numBlockWords;
+    int numBalls;
+    
+    int cellWidth;
+    int cellHeight;
+    int numCellsX;
+    int numCellsY;
+    int numCellBlocks;
+};
+
+size_t world_snapshot_size(World& world);
+
+// Returns the number of bytes written, 0 if the buffer is too small
+size_t world_snapshot_save(World& world, void* buffer, size_t bufferSize);
+
+// world must be created (or zeroed), its arrays are only reallocated if the snapshot doesn't fit them
+// (or the blocks were borrowed from a level file).
+// Returns false and leaves world alone if buffer isn't a snapshot.
+bool world_snapshot_load(World& world, const void* buffer, size_t bufferSize);
+
+#endif
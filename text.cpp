@@ -0,0 +1,138 @@
+#include "text.h"
+#include "render.h"
+
+#include <stdio.h>
+
+bool glyph_atlas_create(GlyphAtlas& atlas, SDL_Renderer* renderer, TTF_Font* font, SDL_Color color)
+{
+    bool success = true;
+    
+    atlas.texture = NULL;
+    atlas.lineHeight = TTF_FontHeight(font);
+    
+    // NOTE(chris) each glyph is rendered as a one character string rather than with TTF_RenderGlyph_Solid,
+    // that way the surface is already a full line high with the glyph sitting on the baseline
+    SDL_Surface* glyphSurfaces[GLYPH_COUNT] = {};
+    
+    int penX = 0;
+    int penY = 0;
+    int atlasWidth = 0;
+    
+    for(int i = 0; i < GLYPH_COUNT; ++i)
+    {
+        char glyphText[2] = {(char)(GLYPH_FIRST + i), '\0'};
+        
+        SDL_Rect& glyph = atlas.glyphs[i];
+        glyph.x = penX;
+        glyph.y = penY;
+        glyph.w = 0;
+        glyph.h = atlas.lineHeight;
+        
+        glyphSurfaces[i] = TTF_RenderText_Solid(font, glyphText, color);
+        if(glyphSurfaces[i] == NULL)
+        {
+            printf("Unable to render glyph '%s'! SDL_ttf Error: %s\n", glyphText, TTF_GetError());
+            continue;
+        }
+        
+        if(penX + glyphSurfaces[i]->w > GLYPH_ATLAS_MAX_WIDTH)
+        {
+            penX = 0;
+            penY += atlas.lineHeight;
+            glyph.x = penX;
+            glyph.y = penY;
+        }
+        
+        glyph.w = glyphSurfaces[i]->w;
+        penX += glyph.w;
+        
+        if(penX > atlasWidth) atlasWidth = penX;
+    }
+    
+    SDL_Surface* atlasSurface = SDL_CreateRGBSurfaceWithFormat(0, atlasWidth, penY + atlas.lineHeight, 32, SDL_PIXELFORMAT_RGBA32);
+    if(atlasSurface == NULL)
+    {
+        printf("Unable to create glyph atlas surface! SDL Error: %s\n", SDL_GetError());
+        success = false;
+    }
+    else
+    {
+        SDL_FillRect(atlasSurface, NULL, SDL_MapRGBA(atlasSurface->format, 0, 0, 0, 0));
+        
+        for(int i = 0; i < GLYPH_COUNT; ++i)
+        {
+            if(glyphSurfaces[i] != NULL)
+            {
+                // Solid glyphs are color keyed, so only the glyph pixels land in the atlas
+                SDL_BlitSurface(glyphSurfaces[i], NULL, atlasSurface, &atlas.glyphs[i]);
+            }
+        }
+        
+        atlas.texture = SDL_CreateTextureFromSurface(renderer, atlasSurface);
+        if(atlas.texture == NULL)
+        {
+            printf("Unable to create glyph atlas texture! SDL Error: %s\n", SDL_GetError());
+            success = false;
+        }
+        
+        SDL_FreeSurface(atlasSurface);
+    }
+    
+    for(int i = 0; i < GLYPH_COUNT; ++i)
+    {
+        SDL_FreeSurface(glyphSurfaces[i]);
+    }
+    
+    return success;
+}
+
+void glyph_atlas_destroy(GlyphAtlas& atlas)
+{
+    SDL_DestroyTexture(atlas.texture);
+    atlas.texture = NULL;
+}
+
+static int glyph_index(char c)
+{
+    int index = c - GLYPH_FIRST;
+    if(index < 0 || index >= GLYPH_COUNT)
+    {
+        index = '?' - GLYPH_FIRST;
+    }
+    
+    return index;
+}
+
+int text_render(SDL_Renderer* renderer, GlyphAtlas& atlas, const char* text, int x, int y)
+{
+    int penX = x;
+    
+    for(const char* c = text; *c != '\0'; ++c)
+    {
+        int index = glyph_index(*c);
+        
+        SDL_Rect& glyph = atlas.glyphs[index];
+        
+        // Spaces only advance the pen
+        if(*c != ' ')
+        {
+            SDL_Rect renderQuad = {penX, y, glyph.w, glyph.h};
+            render_copy(renderer, atlas.texture, &glyph, &renderQuad);
+        }
+        
+        penX += glyph.w;
+    }
+    
+    return penX - x;
+}
+
+int text_width(GlyphAtlas& atlas, const char* text)
+{
+    int width = 0;
+    for(const char* c = text; *c != '\0'; ++c)
+    {
+        width += atlas.glyphs[glyph_index(*c)].w;
+    }
+    
+    return width;
+}
@@ -0,0 +1,32 @@
+#ifndef TEXT_H
+#define TEXT_H
+
+#include "SDL.h"
+#include <SDL_ttf.h>
+
+// Printable ASCII, anything outside this range is drawn as '?'
+const int GLYPH_FIRST = 32;
+const int GLYPH_LAST = 126;
+const int GLYPH_COUNT = GLYPH_LAST - GLYPH_FIRST + 1;
+
+const int GLYPH_ATLAS_MAX_WIDTH = 512;
+
+// Every glyph of a font rasterized once into a single texture, so drawing text is just
+// a SDL_RenderCopy per character with no rasterizing, allocating or uploading per frame
+struct GlyphAtlas
+{
+    SDL_Texture* texture;
+    SDL_Rect glyphs[GLYPH_COUNT]; // source rect of each glyph in the texture
+    int lineHeight;
+};
+
+bool glyph_atlas_create(GlyphAtlas& atlas, SDL_Renderer* renderer, TTF_Font* font, SDL_Color color);
+void glyph_atlas_destroy(GlyphAtlas& atlas);
+
+// Returns the width of the drawn text
+int text_render(SDL_Renderer* renderer, GlyphAtlas& atlas, const char* text, int x, int y);
+
+// What text_render would return, without drawing
+int text_width(GlyphAtlas& atlas, const char* text);
+
+#endif
@@ -0,0 +1,105 @@
+#include "trace.h"
+#include "profile.h"
+
+#include "SDL_timer.h"
+
+#include <chrono>
+
+TraceWriter gTraceWriter;
+
+static void trace_write_event(TraceEvent& event)
+{
+    TraceWriter& writer = gTraceWriter;
+    
+    const char* name = event.scope < PROFILE_SCOPE_COUNT ? gProfileScopeNames[event.scope] : "Frame";
+    double ts = (double)(event.start - writer.origin) * 1000000.0 / (double)writer.frequency;
+    double dur = (double)(event.end - event.start) * 1000000.0 / (double)writer.frequency;
+    
+    fprintf(writer.file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+            writer.firstEvent ? "" : ",", name, ts, dur);
+    writer.firstEvent = false;
+}
+
+// Returns the number of events written
+static int trace_drain()
+{
+    TraceWriter& writer = gTraceWriter;
+    
+    Uint32 tail = writer.tail.load(std::memory_order_relaxed);
+    Uint32 head = writer.head.load(std::memory_order_acquire);
+    
+    for(Uint32 i = tail; i != head; ++i)
+    {
+        trace_write_event(writer.events[i & (TRACE_BUFFER_SIZE - 1)]);
+    }
+    
+    writer.tail.store(head, std::memory_order_release);
+    
+    return (int)(head - tail);
+}
+
+static void trace_writer_thread()
+{
+    while(!gTraceWriter.stop.load(std::memory_order_acquire))
+    {
+        if(trace_drain() == 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+    
+    trace_drain();
+}
+
+bool trace_begin(const char* path)
+{
+    TraceWriter& writer = gTraceWriter;
+    
+    writer.file = fopen(path, "w");
+    if(writer.file == NULL)
+    {
+        printf("Unable to open trace %s for writing!\n", path);
+        return false;
+    }
+    
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", writer.file);
+    
+    writer.firstEvent = true;
+    writer.origin = SDL_GetPerformanceCounter();
+    writer.frequency = SDL_GetPerformanceFrequency();
+    
+    writer.events = new TraceEvent[TRACE_BUFFER_SIZE];
+    writer.head = 0;
+    writer.tail = 0;
+    writer.dropped = 0;
+    
+    writer.stop = false;
+    writer.thread = std::thread(trace_writer_thread);
+    
+    writer.active = true;
+    
+    return true;
+}
+
+void trace_end()
+{
+    TraceWriter& writer = gTraceWriter;
+    if(!writer.active) return;
+    
+    writer.active = false;
+    
+    writer.stop = true;
+    writer.thread.join();
+    
+    fputs("\n]}\n", writer.file);
+    fclose(writer.file);
+    writer.file = NULL;
+    
+    if(writer.dropped)
+    {
+        printf("Trace buffer was full, dropped %u events\n", writer.dropped);
+    }
+    
+    delete[] writer.events;
+    writer.events = NULL;
+}
@@ -0,0 +1,66 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "SDL_stdinc.h"
+
+#include <atomic>
+#include <stdio.h>
+#include <thread>
+
+// Writes profiler scopes out as Chrome trace-event JSON (chrome://tracing, Perfetto, Speedscope).
+// The main thread pushes events into a single producer/single consumer ring and a writer thread
+// formats them out to the file, so tracing doesn't put file IO on the frame.
+
+const int TRACE_BUFFER_SIZE = 1 << 16; // events, must be a power of two
+
+struct TraceEvent
+{
+    int scope; // a ProfileScope, or PROFILE_SCOPE_COUNT for the whole frame
+    Uint64 start;
+    Uint64 end;
+};
+
+struct TraceWriter
+{
+    bool active;
+    
+    FILE* file;
+    bool firstEvent;
+    Uint64 origin; // performance counter at trace_begin, ts 0 in the trace
+    Uint64 frequency;
+    
+    TraceEvent* events;
+    std::atomic<Uint32> head; // next slot the producer writes
+    std::atomic<Uint32> tail; // next slot the writer thread reads
+    Uint32 dropped;           // ring was full, only touched by the producer
+    
+    std::atomic<bool> stop;
+    std::thread thread;
+};
+
+extern TraceWriter gTraceWriter;
+
+bool trace_begin(const char* path);
+
+// Flushes everything still in the ring and closes the file
+void trace_end();
+
+// Main thread only
+inline void trace_event(int scope, Uint64 start, Uint64 end)
+{
+    Uint32 head = gTraceWriter.head.load(std::memory_order_relaxed);
+    if(head - gTraceWriter.tail.load(std::memory_order_acquire) == TRACE_BUFFER_SIZE)
+    {
+        ++gTraceWriter.dropped;
+        return;
+    }
+    
+    TraceEvent& event = gTraceWriter.events[head & (TRACE_BUFFER_SIZE - 1)];
+    event.scope = scope;
+    event.start = start;
+    event.end = end;
+    
+    gTraceWriter.head.store(head + 1, std::memory_order_release);
+}
+
+#endif